@@ -12,6 +12,7 @@ def write_file_open(out: TextIOWrapper) :
 
         "#include <array>\n\n"
 
+        "#include <shrimp/common/bitops.hpp>\n"
         "#include <shrimp/common/types.hpp>\n"
         "#include <shrimp/common/instr_opcode.gen.hpp>\n\n"
 
@@ -26,7 +27,10 @@ def write_file_open(out: TextIOWrapper) :
             "virtual size_t getByteSize() const noexcept = 0;\n\n"
 
             "// Get ptr to buff with instruction binary code\n"
-            "virtual const Byte *getBinCode() const noexcept = 0;\n"
+            "virtual const Byte *getBinCode() const noexcept = 0;\n\n"
+
+            "// Get instruction opcode\n"
+            "virtual InstrOpcode getOpcode() const noexcept = 0;\n\n"
 
             "virtual ~InterfaceInstr() = default;"
         "};\n\n"
@@ -46,6 +50,19 @@ def write_instr_spec(out: TextIOWrapper, instr: Instr) :
     out.write("public:\n")
     out.write("size_t getByteSize() const noexcept override { return %d; }\n" % INSTR_SIZES[instr.size])
     out.write("const Byte *getBinCode() const noexcept override { return reinterpret_cast<const Byte*>(&bin_code_); }\n\n")
+    out.write("InstrOpcode getOpcode() const noexcept override { return %s; }\n\n" % instr.get_opcode_name())
+
+    for field_name, field in instr.fields.items() :
+        right_shift = INSTR_BIT_SIZES[instr.size] - field.hi - 1
+        left_shift = field.lo + right_shift
+
+        out.write("[[nodiscard]] uint64_t get%s() const noexcept {\n" % name_to_camel(field_name))
+        out.write("auto unsigned_value = bin_code_ << %d >> %d;\n" % (right_shift, left_shift))
+        if field.is_signed :
+            out.write("return bit::signExtend<uint64_t, %d>(unsigned_value);\n" % (field.get_bit_size() - 1))
+        else :
+            out.write("return unsigned_value;\n")
+        out.write("}\n\n")
 
     if instr.is_jump :
         jump_offset = instr.fields["jump_offset"]
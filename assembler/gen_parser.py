@@ -34,10 +34,10 @@ def write_instr_parser(out: TextIOWrapper, instr: Instr) :
         need_comma = True
 
         match field_name :
-            case "rd" | "rs" | "rs1" | "rs2" | "func_arg0" | "func_arg1" | "func_arg2" | "func_arg3" :
+            case "rd" | "rs" | "rs1" | "rs2" | "func_arg0" | "func_arg1" | "func_arg2" | "func_arg3" | "func_arg_start" :
                 out.write("uint64_t %s = parseReg();\n" % field_name)
 
-            case "imm_i32" | "imm_i64" :
+            case "imm_i32" | "imm_i64" | "func_num_args" :
                 out.write("uint64_t %s = parseImmI();\n" % field_name)
 
             case "imm_f" :
@@ -7,6 +7,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -22,6 +24,7 @@
 
 #include <shrimp/assembler/instr.gen.hpp>
 #include <shrimp/assembler/lexer.hpp>
+#include <shrimp/assembler/stack_maps.hpp>
 
 #include <shrimp/shrimpfile.hpp>
 
@@ -228,14 +231,13 @@ class Assembler final {
         R8Id reg_id = 0;
         const char *reg_name = lexer_.YYText();
 
+        // Function arguments occupy first registers of window, other registers follow them
         const auto &args = curr_func_->getArgs();
-        bool found_arg = std::any_of(args.cbegin(), args.cend(), [&](const std::string &arg) {
-            --reg_id;
-            return std::strcmp(arg.c_str(), reg_name) == 0;
-        });
+        auto arg_it = std::find_if(args.cbegin(), args.cend(),
+                                   [&](const std::string &arg) { return std::strcmp(arg.c_str(), reg_name) == 0; });
 
-        if (found_arg) {
-            return reg_id;
+        if (arg_it != args.cend()) {
+            return std::distance(args.cbegin(), arg_it);
         }
 
         assertParseError(std::toupper(lexer_.YYText()[0]) == 'R');
@@ -247,8 +249,9 @@ class Assembler final {
 
         assertParseError(ec == std::errc());
         assertParseError(reg_id_end == end);
+        assertParseError(reg_id + args.size() <= std::numeric_limits<R8Id>::max());
 
-        return reg_id;
+        return reg_id + args.size();
     }
 
     // Parse expected int64_t immediate
@@ -373,7 +376,18 @@ class Assembler final {
                                                                             {"COS", IntrinsicCode::COS},
                                                                             {"SQRT", IntrinsicCode::SQRT},
                                                                             {"CONCAT", IntrinsicCode::CONCAT},
-                                                                            {"SUBSTR", IntrinsicCode::SUBSTR}};
+                                                                            {"SUBSTR", IntrinsicCode::SUBSTR},
+                                                                            {"STR.INTERN", IntrinsicCode::STR_INTERN},
+                                                                            {"STR.EQ", IntrinsicCode::STR_EQ},
+                                                                            {"ARR.FILL", IntrinsicCode::ARR_FILL},
+                                                                            {"ARR.COPY", IntrinsicCode::ARR_COPY},
+                                                                            {"ARR.SUM.I32", IntrinsicCode::ARR_SUM_I32},
+                                                                            {"ARR.SUM.F", IntrinsicCode::ARR_SUM_F},
+                                                                            {"ARR.DOT.F", IntrinsicCode::ARR_DOT_F},
+                                                                            {"ARR.AXPY.F", IntrinsicCode::ARR_AXPY_F},
+                                                                            {"ARR.MIN", IntrinsicCode::ARR_MIN},
+                                                                            {"ARR.MAX", IntrinsicCode::ARR_MAX},
+                                                                            {"FLUSH", IntrinsicCode::FLUSH}};
 
         expectLexem(Lexer::LexemType::IDENTIFIER);
 
@@ -397,6 +411,7 @@ class Assembler final {
 
             case IntrinsicCode::SCAN_I32:
             case IntrinsicCode::SCAN_F:
+            case IntrinsicCode::FLUSH:
                 return {0, 0, 0, 0};
 
             case IntrinsicCode::SIN:
@@ -419,7 +434,11 @@ class Assembler final {
                 return {reg1, reg2, 0, 0};
             }
 
-            case IntrinsicCode::SUBSTR: {
+            case IntrinsicCode::SUBSTR:
+            case IntrinsicCode::STR_EQ:
+            case IntrinsicCode::ARR_FILL:
+            case IntrinsicCode::ARR_COPY:
+            case IntrinsicCode::ARR_DOT_F: {
                 expectLexem(Lexer::LexemType::COMMA);
                 auto reg1 = parseReg();
                 expectLexem(Lexer::LexemType::COMMA);
@@ -427,6 +446,24 @@ class Assembler final {
                 return {reg1, reg2, 0, 0};
             }
 
+            case IntrinsicCode::STR_INTERN:
+            case IntrinsicCode::ARR_SUM_I32:
+            case IntrinsicCode::ARR_SUM_F:
+            case IntrinsicCode::ARR_MIN:
+            case IntrinsicCode::ARR_MAX:
+                expectLexem(Lexer::LexemType::COMMA);
+                return {parseReg(), 0, 0, 0};
+
+            case IntrinsicCode::ARR_AXPY_F: {
+                expectLexem(Lexer::LexemType::COMMA);
+                auto reg1 = parseReg();
+                expectLexem(Lexer::LexemType::COMMA);
+                auto reg2 = parseReg();
+                expectLexem(Lexer::LexemType::COMMA);
+                auto reg3 = parseReg();
+                return {reg1, reg2, reg3, 0};
+            }
+
             default:
                 std::abort();
                 // assert(0);
@@ -468,7 +505,8 @@ class Assembler final {
 
         assertParseError(lexer_.currLexemType() == Lexer::LexemType::RIGHT_ROUND_BRACE);
 
-        static constexpr size_t MAX_FUNC_ARGS_NUMBER = 4;
+        // More than 4 arguments are passed with call.range
+        static constexpr size_t MAX_FUNC_ARGS_NUMBER = 16;
         assertParseError(args.size() <= MAX_FUNC_ARGS_NUMBER);
 
         funcs_.emplace_back(curr_offset_, func_name, args);
@@ -534,6 +572,8 @@ class Assembler final {
         expectLexem(Lexer::LexemType::IDENTIFIER);
 
         std::string class_name = lexer_.YYText();
+        // Registered before fields, so they may refer to class itself
+        class_name_to_id_.insert({class_name, classes_.size()});
 
         std::vector<FieldInfo> fields {};
 
@@ -560,8 +600,6 @@ class Assembler final {
             class_size += type_size;
         }
 
-        class_name_to_id_.insert({class_name, classes_.size()});
-
         classes_.emplace_back(class_name, class_size);
         classes_.back().fields() = std::move(fields);
     }
@@ -589,9 +627,32 @@ class Assembler final {
         writeStrings(out);
         writeFunctions(out);
         writeClasses(out);
+        writeStackMaps(out);
         out.fillHeaders();
     }
 
+    void writeStackMaps(shrimp::shrimpfile::File &out)
+    {
+        StackMapBuilder builder;
+        for (auto &&klass : classes_) {
+            std::vector<bool> ref_fields;
+            for (const auto &field : klass.fields()) {
+                ref_fields.push_back(field.isRef() != 0);
+            }
+            builder.addClass(class_name_to_id_[klass.name()], std::move(ref_fields));
+        }
+        for (auto &&func : funcs_) {
+            std::vector<const InterfaceInstr *> instrs;
+            for (auto &&instr_ptr : func.instrs()) {
+                instrs.push_back(instr_ptr.get());
+            }
+            builder.addFunction(func_name_to_id_[func.name()], func.offset(), func.getArgs().size(), std::move(instrs));
+        }
+        for (auto &&stack_map : builder.build()) {
+            out.writeStackMap(stack_map);
+        }
+    }
+
     void writeClasses(shrimp::shrimpfile::File &out)
     {
         for (auto &&klass : classes_) {
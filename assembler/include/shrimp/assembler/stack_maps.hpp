@@ -0,0 +1,422 @@
+#ifndef INCLUDE_SHRIMP_ASSEMBLER_STACK_MAPS_HPP
+#define INCLUDE_SHRIMP_ASSEMBLER_STACK_MAPS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <shrimp/common/types.hpp>
+#include <shrimp/common/instr_opcode.gen.hpp>
+
+#include <shrimp/assembler/instr.gen.hpp>
+
+#include <shrimp/shrimpfile.hpp>
+
+namespace shrimp::assembler {
+
+// Infer which registers hold references at every safepoint (calls, intrinsics
+// and allocations) and emit stack maps, so GC scans frames without runtime marks.
+// Kinds are joined over all paths to instruction; registers holding reference on
+// one path and value on another are reported as ambiguous
+class StackMapBuilder final {
+public:
+    void addClass(ClassId id, std::vector<bool> ref_fields)
+    {
+        classes_[id] = std::move(ref_fields);
+    }
+
+    void addFunction(FuncId id, ByteOffset start, size_t num_args, std::vector<const InterfaceInstr *> instrs)
+    {
+        func_id_to_idx_.insert({id, funcs_.size()});
+        funcs_.push_back(FuncInfo {start, std::move(instrs), std::vector<Kind>(num_args, NONE), NONE});
+    }
+
+    std::vector<shrimpfile::File::FileStackMap> build()
+    {
+        // Argument and return kinds depend on call sites and callees, iterate until they settle
+        do {
+            changed_ = false;
+            for (auto &func : funcs_) {
+                analyze(func, nullptr);
+            }
+        } while (changed_);
+
+        std::vector<shrimpfile::File::FileStackMap> maps;
+        for (auto &func : funcs_) {
+            analyze(func, &maps);
+        }
+        std::sort(maps.begin(), maps.end(), [](const auto &lhs, const auto &rhs) { return lhs.offset < rhs.offset; });
+        return maps;
+    }
+
+private:
+    enum Kind : uint8_t { NONE = 0, VALUE = 1, REF = 2, AMBIGUOUS = VALUE | REF };
+
+    static constexpr size_t NUM_OF_REGS = 256;
+
+    struct State {
+        std::array<Kind, NUM_OF_REGS> regs {};
+        Kind acc = NONE;
+
+        // Join other state into this one, return true if it was changed
+        bool join(const State &other) noexcept
+        {
+            bool changed = joinKind(acc, other.acc);
+            for (size_t i = 0; i < NUM_OF_REGS; i++) {
+                changed |= joinKind(regs[i], other.regs[i]);
+            }
+            return changed;
+        }
+    };
+
+    struct FuncInfo {
+        ByteOffset start = 0;
+        std::vector<const InterfaceInstr *> instrs {};
+        std::vector<Kind> args {};
+        Kind ret = NONE;
+    };
+
+    static bool joinKind(Kind &kind, Kind other) noexcept
+    {
+        auto joined = static_cast<Kind>(kind | other);
+        bool changed = joined != kind;
+        kind = joined;
+        return changed;
+    }
+
+    template <InstrOpcode op>
+    static const Instr<op> *as(const InterfaceInstr *instr) noexcept
+    {
+        return static_cast<const Instr<op> *>(instr);
+    }
+
+    static bool isSafepoint(InstrOpcode opcode) noexcept
+    {
+        switch (opcode) {
+            case InstrOpcode::CALL_0ARG:
+            case InstrOpcode::CALL_1ARG:
+            case InstrOpcode::CALL_2ARG:
+            case InstrOpcode::CALL_3ARG:
+            case InstrOpcode::CALL_4ARG:
+            case InstrOpcode::CALL_RANGE:
+            case InstrOpcode::INTRINSIC:
+            case InstrOpcode::LDA_STR:
+            case InstrOpcode::ARR_NEW_I32:
+            case InstrOpcode::ARR_NEW_F:
+            case InstrOpcode::ARR_NEW_REF:
+            case InstrOpcode::OBJ_NEW:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool isConditionalJump(InstrOpcode opcode) noexcept
+    {
+        switch (opcode) {
+            case InstrOpcode::JUMP_GG:
+            case InstrOpcode::JUMP_EQ:
+            case InstrOpcode::JUMP_NOT_EQ:
+            case InstrOpcode::JUMP_LL:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static ByteOffset getJumpOffset(const InterfaceInstr *instr) noexcept
+    {
+        switch (instr->getOpcode()) {
+            case InstrOpcode::JUMP:
+                return as<InstrOpcode::JUMP>(instr)->getJumpOffset();
+            case InstrOpcode::JUMP_GG:
+                return as<InstrOpcode::JUMP_GG>(instr)->getJumpOffset();
+            case InstrOpcode::JUMP_EQ:
+                return as<InstrOpcode::JUMP_EQ>(instr)->getJumpOffset();
+            case InstrOpcode::JUMP_NOT_EQ:
+                return as<InstrOpcode::JUMP_NOT_EQ>(instr)->getJumpOffset();
+            case InstrOpcode::JUMP_LL:
+                return as<InstrOpcode::JUMP_LL>(instr)->getJumpOffset();
+            default:
+                std::abort();
+        }
+    }
+
+    FuncInfo *resolveFunc(FuncId id) noexcept
+    {
+        auto it = func_id_to_idx_.find(id);
+        return it == func_id_to_idx_.end() ? nullptr : &funcs_[it->second];
+    }
+
+    // Propagate argument kinds to callee and get kind of its return value
+    Kind call(FuncId id, const std::vector<Kind> &args)
+    {
+        auto *callee = resolveFunc(id);
+        if (callee == nullptr) {
+            return AMBIGUOUS;
+        }
+        for (size_t i = 0; i < std::min(args.size(), callee->args.size()); i++) {
+            changed_ |= joinKind(callee->args[i], args[i]);
+        }
+        return callee->ret;
+    }
+
+    Kind getFieldKind(ClassId class_id, FieldId field_id) const
+    {
+        auto it = classes_.find(class_id);
+        if (it == classes_.end() || field_id >= it->second.size()) {
+            return AMBIGUOUS;
+        }
+        return it->second[field_id] ? REF : VALUE;
+    }
+
+    void transfer(const InterfaceInstr *instr, State &state)
+    {
+        auto &regs = state.regs;
+        switch (instr->getOpcode()) {
+            case InstrOpcode::MOV: {
+                auto *mov = as<InstrOpcode::MOV>(instr);
+                regs[mov->getRd()] = regs[mov->getRs()];
+                break;
+            }
+            case InstrOpcode::MOV_IMM_I32:
+                regs[as<InstrOpcode::MOV_IMM_I32>(instr)->getRd()] = VALUE;
+                break;
+            case InstrOpcode::MOV_IMM_F:
+                regs[as<InstrOpcode::MOV_IMM_F>(instr)->getRd()] = VALUE;
+                break;
+            case InstrOpcode::LDA:
+                state.acc = regs[as<InstrOpcode::LDA>(instr)->getRs()];
+                break;
+            case InstrOpcode::STA:
+                regs[as<InstrOpcode::STA>(instr)->getRd()] = state.acc;
+                break;
+            case InstrOpcode::LDA_IMM_I32:
+            case InstrOpcode::LDA_IMM_F:
+            case InstrOpcode::ADD_I32:
+            case InstrOpcode::ADD_F:
+            case InstrOpcode::SUB_I32:
+            case InstrOpcode::SUB_F:
+            case InstrOpcode::MOD:
+            case InstrOpcode::DIV_I32:
+            case InstrOpcode::DIV_F:
+            case InstrOpcode::MUL_I32:
+            case InstrOpcode::MUL_F:
+            case InstrOpcode::I32TOF:
+            case InstrOpcode::FTOI32:
+            case InstrOpcode::ARR_LENGTH:
+            case InstrOpcode::ARR_LDA_I32:
+            case InstrOpcode::ARR_LDA_F:
+            case InstrOpcode::ARR_LDA_I32_NC:
+            case InstrOpcode::ARR_LDA_F_NC:
+            case InstrOpcode::CMP_EQ_I32:
+            case InstrOpcode::CMP_GG_I32:
+            case InstrOpcode::CMP_LL_I32:
+                state.acc = VALUE;
+                break;
+            case InstrOpcode::LDA_STR:
+            case InstrOpcode::ARR_LDA_REF:
+                state.acc = REF;
+                break;
+            case InstrOpcode::ARR_NEW_I32:
+                regs[as<InstrOpcode::ARR_NEW_I32>(instr)->getRd()] = REF;
+                break;
+            case InstrOpcode::ARR_NEW_F:
+                regs[as<InstrOpcode::ARR_NEW_F>(instr)->getRd()] = REF;
+                break;
+            case InstrOpcode::ARR_NEW_REF:
+                regs[as<InstrOpcode::ARR_NEW_REF>(instr)->getRd()] = REF;
+                break;
+            case InstrOpcode::OBJ_NEW:
+                regs[as<InstrOpcode::OBJ_NEW>(instr)->getRd()] = REF;
+                break;
+            case InstrOpcode::LDFIELD: {
+                auto *ldfield = as<InstrOpcode::LDFIELD>(instr);
+                regs[ldfield->getRd()] = getFieldKind(ldfield->getClassId(), ldfield->getFieldId());
+                break;
+            }
+            case InstrOpcode::INTRINSIC: {
+                switch (static_cast<IntrinsicCode>(as<InstrOpcode::INTRINSIC>(instr)->getIntrinsicCode())) {
+                    case IntrinsicCode::CONCAT:
+                    case IntrinsicCode::SUBSTR:
+                    case IntrinsicCode::STR_INTERN:
+                        state.acc = REF;
+                        break;
+                    case IntrinsicCode::SCAN_I32:
+                    case IntrinsicCode::SCAN_F:
+                    case IntrinsicCode::SIN:
+                    case IntrinsicCode::COS:
+                    case IntrinsicCode::SQRT:
+                    case IntrinsicCode::ARR_SUM_I32:
+                    case IntrinsicCode::ARR_SUM_F:
+                    case IntrinsicCode::ARR_DOT_F:
+                    case IntrinsicCode::ARR_MIN:
+                    case IntrinsicCode::ARR_MAX:
+                    case IntrinsicCode::STR_EQ:
+                        state.acc = VALUE;
+                        break;
+                    default:
+                        break;
+                }
+                break;
+            }
+            case InstrOpcode::CALL_0ARG:
+                state.acc = call(as<InstrOpcode::CALL_0ARG>(instr)->getFuncId(), {});
+                break;
+            case InstrOpcode::CALL_1ARG: {
+                auto *call_instr = as<InstrOpcode::CALL_1ARG>(instr);
+                state.acc = call(call_instr->getFuncId(), {regs[call_instr->getFuncArg0()]});
+                break;
+            }
+            case InstrOpcode::CALL_2ARG: {
+                auto *call_instr = as<InstrOpcode::CALL_2ARG>(instr);
+                state.acc =
+                    call(call_instr->getFuncId(), {regs[call_instr->getFuncArg0()], regs[call_instr->getFuncArg1()]});
+                break;
+            }
+            case InstrOpcode::CALL_3ARG: {
+                auto *call_instr = as<InstrOpcode::CALL_3ARG>(instr);
+                state.acc = call(call_instr->getFuncId(), {regs[call_instr->getFuncArg0()],
+                                                           regs[call_instr->getFuncArg1()],
+                                                           regs[call_instr->getFuncArg2()]});
+                break;
+            }
+            case InstrOpcode::CALL_4ARG: {
+                auto *call_instr = as<InstrOpcode::CALL_4ARG>(instr);
+                state.acc = call(call_instr->getFuncId(),
+                                 {regs[call_instr->getFuncArg0()], regs[call_instr->getFuncArg1()],
+                                  regs[call_instr->getFuncArg2()], regs[call_instr->getFuncArg3()]});
+                break;
+            }
+            case InstrOpcode::CALL_RANGE: {
+                auto *call_instr = as<InstrOpcode::CALL_RANGE>(instr);
+                size_t arg_start = call_instr->getFuncArgStart();
+                size_t arg_end = std::min(arg_start + call_instr->getFuncNumArgs(), NUM_OF_REGS);
+                std::vector<Kind> args(regs.begin() + arg_start, regs.begin() + arg_end);
+                state.acc = call(call_instr->getFuncId(), args);
+                // Callee window overlaps them, so they may hold anything after return
+                std::fill(regs.begin() + arg_start, regs.end(), AMBIGUOUS);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void addStackMap(ByteOffset offset, const InterfaceInstr *instr, const State &state,
+                     std::vector<shrimpfile::File::FileStackMap> &maps) const
+    {
+        auto opcode = instr->getOpcode();
+
+        shrimpfile::File::FileStackMap stack_map;
+        stack_map.offset = offset;
+
+        // Call sites are scanned in caller frames, acc is overwritten by callee then
+        bool is_call = opcode == InstrOpcode::CALL_0ARG || opcode == InstrOpcode::CALL_1ARG ||
+                       opcode == InstrOpcode::CALL_2ARG || opcode == InstrOpcode::CALL_3ARG ||
+                       opcode == InstrOpcode::CALL_4ARG || opcode == InstrOpcode::CALL_RANGE;
+        if (!is_call && state.acc == REF) {
+            stack_map.acc_kind = shrimpfile::File::ACC_REF;
+        } else if (!is_call && state.acc == AMBIGUOUS) {
+            stack_map.acc_kind = shrimpfile::File::ACC_AMBIGUOUS;
+        }
+
+        // Registers from range start belong to callee window while it runs
+        size_t num_of_regs = NUM_OF_REGS;
+        if (opcode == InstrOpcode::CALL_RANGE) {
+            num_of_regs = as<InstrOpcode::CALL_RANGE>(instr)->getFuncArgStart();
+        }
+        for (size_t i = 0; i < num_of_regs; i++) {
+            if (state.regs[i] == REF) {
+                stack_map.refs.push_back(i);
+            } else if (state.regs[i] == AMBIGUOUS) {
+                stack_map.ambiguous.push_back(i);
+            }
+        }
+        stack_map.num_of_refs = stack_map.refs.size();
+        stack_map.num_of_ambiguous = stack_map.ambiguous.size();
+        maps.push_back(std::move(stack_map));
+    }
+
+    // Compute register kinds before each instruction of function, emit stack maps if requested
+    void analyze(FuncInfo &func, std::vector<shrimpfile::File::FileStackMap> *maps)
+    {
+        auto &instrs = func.instrs;
+        if (instrs.empty()) {
+            return;
+        }
+
+        std::vector<ByteOffset> offsets(instrs.size());
+        std::unordered_map<ByteOffset, size_t> offset_to_idx;
+        ByteOffset offset = func.start;
+        for (size_t i = 0; i < instrs.size(); i++) {
+            offsets[i] = offset;
+            offset_to_idx.insert({offset, i});
+            offset += instrs[i]->getByteSize();
+        }
+
+        std::vector<std::optional<State>> states(instrs.size());
+        states[0] = State {};
+        for (size_t i = 0; i < func.args.size(); i++) {
+            states[0]->regs[i] = func.args[i];
+        }
+
+        std::vector<size_t> worklist {0};
+        auto propagate = [&](size_t idx, const State &state) {
+            if (!states[idx].has_value()) {
+                states[idx] = state;
+                worklist.push_back(idx);
+            } else if (states[idx]->join(state)) {
+                worklist.push_back(idx);
+            }
+        };
+
+        while (!worklist.empty()) {
+            size_t idx = worklist.back();
+            worklist.pop_back();
+
+            const auto *instr = instrs[idx];
+            State state = *states[idx];
+            transfer(instr, state);
+
+            auto opcode = instr->getOpcode();
+            if (opcode == InstrOpcode::RET) {
+                changed_ |= joinKind(func.ret, state.acc);
+                continue;
+            }
+            if (opcode == InstrOpcode::JUMP || isConditionalJump(opcode)) {
+                auto target_it = offset_to_idx.find(offsets[idx] + getJumpOffset(instr));
+                if (target_it != offset_to_idx.end()) {
+                    propagate(target_it->second, state);
+                }
+                if (opcode == InstrOpcode::JUMP) {
+                    continue;
+                }
+            }
+            if (idx + 1 < instrs.size()) {
+                propagate(idx + 1, state);
+            }
+        }
+
+        if (maps == nullptr) {
+            return;
+        }
+        for (size_t i = 0; i < instrs.size(); i++) {
+            if (isSafepoint(instrs[i]->getOpcode()) && states[i].has_value()) {
+                addStackMap(offsets[i], instrs[i], *states[i], *maps);
+            }
+        }
+    }
+
+    std::vector<FuncInfo> funcs_ {};
+    std::unordered_map<FuncId, size_t> func_id_to_idx_ {};
+    std::unordered_map<ClassId, std::vector<bool>> classes_ {};
+    bool changed_ = false;
+};
+
+}  // namespace shrimp::assembler
+
+#endif  // INCLUDE_SHRIMP_ASSEMBLER_STACK_MAPS_HPP
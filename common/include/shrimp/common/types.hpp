@@ -35,7 +35,29 @@ using ClassId = uint32_t;
 // Field id
 using FieldId = uint32_t;
 
-enum class IntrinsicCode : uint8_t { PRINT_I32, PRINT_F, PRINT_STR, CONCAT, SUBSTR, SCAN_I32, SCAN_F, SIN, COS, SQRT };
+enum class IntrinsicCode : uint8_t {
+    PRINT_I32,
+    PRINT_F,
+    PRINT_STR,
+    CONCAT,
+    SUBSTR,
+    SCAN_I32,
+    SCAN_F,
+    SIN,
+    COS,
+    SQRT,
+    ARR_FILL,
+    ARR_COPY,
+    ARR_SUM_I32,
+    ARR_SUM_F,
+    ARR_DOT_F,
+    ARR_AXPY_F,
+    ARR_MIN,
+    ARR_MAX,
+    STR_INTERN,
+    STR_EQ,
+    FLUSH
+};
 
 using StringAccessor = std::unordered_map<StrId, std::string>;
 
@@ -69,12 +91,21 @@ struct RuntimeClass final : BaseClass {
     FieldAccessor fields = {};
 };
 
-struct RuntimeArray final : BaseClass {
-    uint64_t size = 0;
-    RuntimeClass *klass = nullptr;
+enum class StringKind : uint8_t { FLAT, SLICE, ROPE };
+
+// Class of strings shared by all strings of one representation
+struct RuntimeString final : BaseClass {
+    StringKind kind = StringKind::FLAT;
 };
 
-using ArrayAccessor = std::vector<RuntimeArray>;
+enum class ArrayElemType : uint8_t { I32, F, REF };
+
+// Class of arrays shared by all arrays of one element type or element class
+struct RuntimeArray final : BaseClass {
+    ArrayElemType elem_type = ArrayElemType::I32;
+    // Class of elements of reference arrays
+    const RuntimeClass *klass = nullptr;
+};
 using ClassAccessor = std::vector<RuntimeClass>;
 
 }  // namespace shrimp
@@ -53,6 +53,13 @@ public:
         COS,
         CONCAT,
         SUBSTR,
+        ARR_FILL,
+        ARR_COPY,
+        ARR_SUM,
+        ARR_DOT,
+        ARR_AXPY,
+        ARR_MIN,
+        ARR_MAX,
     };
 
 public:
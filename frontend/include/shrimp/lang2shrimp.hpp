@@ -2,12 +2,14 @@
 #define FRONTEND_LANG2SHRIMP_HPP
 
 #include <memory>
+#include <optional>
 #include <shrimp/lexer.hpp>
 #include <shrimp/parser.hpp>
 
 #include <shrimp/common/types.hpp>
 
 #include <shrimp/assembler/instr.gen.hpp>
+#include <shrimp/assembler/stack_maps.hpp>
 
 #include <string>
 #include <unordered_map>
@@ -92,10 +94,16 @@ public:
     void compileArithmOperation(const std::unique_ptr<ASTNode> &expr, const std::string &source);
     void getFromExpr(const std::unique_ptr<ASTNode> &child);
 
+    // Bounds check elimination for array accesses indexed by induction variables of for loops
+    void collectArrLengths(const ASTNode *node);
+    std::optional<std::pair<std::string, int64_t>> getLoopBound(const std::unique_ptr<ASTNode> &instr);
+    bool isIndexInBounds(const std::unique_ptr<ASTNode> &arr);
+
     void write(shrimp::shrimpfile::File &out);
     void writeCode(shrimp::shrimpfile::File &out);
     void writeStrings(shrimp::shrimpfile::File &out);
     void writeFunctions(shrimp::shrimpfile::File &out);
+    void writeStackMaps(shrimp::shrimpfile::File &out);
 
 private:
     std::string input_file_;
@@ -111,6 +119,11 @@ private:
     std::vector<CompilerFuncInfo> funcs_ {};
     CompilerFuncInfo *curr_func_;
 
+    // Lengths of arrays of current function, -1 if array is created with different lengths or reassigned
+    std::unordered_map<std::string, int64_t> arr_lengths_ {};
+    // Induction variables of enclosing for loops mapped to exclusive upper bounds, lower bounds are non-negative
+    std::unordered_map<std::string, int64_t> loop_bounds_ {};
+
     Lexer lexer_;
     Parser parser_;
 };
@@ -45,6 +45,13 @@ enum class TokenType {
     COS,
     CONCAT,
     SUBSTR,
+    ARR_FILL,
+    ARR_COPY,
+    ARR_SUM,
+    ARR_DOT,
+    ARR_AXPY,
+    ARR_MIN,
+    ARR_MAX,
 
     // End of file
     END,
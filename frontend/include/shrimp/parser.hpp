@@ -24,6 +24,9 @@ public:
     }
 
 private:
+    // Calls with more than 4 arguments are compiled to call.range
+    static constexpr size_t MAX_FUNC_ARGS = 16;
+
     template <TokenType TOKEN_TYPE>
     bool inline term(std::string *str = nullptr)
     {
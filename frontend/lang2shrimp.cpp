@@ -1,11 +1,14 @@
 #include <sys/types.h>
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <shrimp/lang2shrimp.hpp>
 #include <shrimp/frontend/astnode.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <shrimp/shrimpfile.hpp>
+#include "shrimp/common/bitops.hpp"
 #include "shrimp/common/types.hpp"
 
 namespace shrimp {
@@ -50,6 +53,7 @@ void Compiler::write(shrimp::shrimpfile::File &out)
     writeCode(out);
     writeStrings(out);
     writeFunctions(out);
+    writeStackMaps(out);
     out.fillHeaders();
     out.serialize();
 }
@@ -85,6 +89,22 @@ void Compiler::writeFunctions(shrimp::shrimpfile::File &out)
     }
 }
 
+void Compiler::writeStackMaps(shrimp::shrimpfile::File &out)
+{
+    assembler::StackMapBuilder builder;
+    for (auto &&func : funcs_) {
+        std::vector<const assembler::InterfaceInstr *> instrs;
+        for (auto &&instr_ptr : func.getInstrs()) {
+            instrs.push_back(instr_ptr.get());
+        }
+        builder.addFunction(funcName_to_id_[func.getName()], func.getOffset(), func.getArgs().size(),
+                            std::move(instrs));
+    }
+    for (auto &&stack_map : builder.build()) {
+        out.writeStackMap(stack_map);
+    }
+}
+
 void Compiler::compileStatements(const ASTNode *node)
 {
     auto &instrsuctions = node->GetChildrenNodes();
@@ -130,14 +150,141 @@ void Compiler::compileFunc(const std::unique_ptr<ASTNode> &ast)
 
     auto &regMap = curr_func_->getRegMap();
 
-    R8Id pos = 255;
+    // Function arguments occupy first registers of window
+    R8Id pos = 0;
     for (auto &arg : func->getArgs()) {
-        regMap.insert({arg.first, {pos, arg.second}});
+        regMap.insert({arg.first, {pos++, arg.second}});
     }
 
+    arr_lengths_.clear();
+    collectArrLengths(func);
+
     compileStatements(func);
 }
 
+// Get value of expression made of single i32 constant
+static std::optional<int64_t> getIntConst(const ASTNode *expr)
+{
+    const auto &childs = expr->GetChildrenNodes();
+    if (expr->GetKind() != ASTNode::NodeKind::EXPR || !expr->GetName().empty() || childs.size() != 1 ||
+        childs[0]->GetKind() != ASTNode::NodeKind::NUMBER) {
+        return std::nullopt;
+    }
+    auto *number = reinterpret_cast<Number *>(childs[0].get());
+    if (number->getType() != ValueType::INT) {
+        return std::nullopt;
+    }
+    return bit::getValue<int32_t>(number->getValue());
+}
+
+// Check if expression is made of single variable with given name
+static bool isVariable(const ASTNode *expr, const std::string &name)
+{
+    const auto &childs = expr->GetChildrenNodes();
+    return expr->GetKind() == ASTNode::NodeKind::EXPR && expr->GetName().empty() && childs.size() == 1 &&
+           childs[0]->GetKind() == ASTNode::NodeKind::IDENTIFIER && childs[0]->GetName() == name;
+}
+
+// Check if variable is declared, assigned or array is created with given name anywhere in node
+static bool isAssigned(const ASTNode *node, const std::string &name)
+{
+    const auto &childs = node->GetChildrenNodes();
+    if (node->GetKind() == ASTNode::NodeKind::ASSIGN_EXPR && !childs.empty() && childs[0]->GetName() == name) {
+        // Store to element keeps array itself
+        bool is_elem_store = childs[0]->GetKind() == ASTNode::NodeKind::ARRAY && childs.size() == 2;
+        if (!is_elem_store) {
+            return true;
+        }
+    }
+    return std::any_of(childs.begin(), childs.end(), [&name](auto &child) { return isAssigned(child.get(), name); });
+}
+
+void Compiler::collectArrLengths(const ASTNode *node)
+{
+    const auto &childs = node->GetChildrenNodes();
+    if (node->GetKind() == ASTNode::NodeKind::ASSIGN_EXPR && !childs.empty()) {
+        const auto &var = childs[0];
+        const auto &var_childs = var->GetChildrenNodes();
+        if (var->GetKind() == ASTNode::NodeKind::ARRAY && childs.size() == 1) {
+            int64_t length = -1;
+            if (var_childs.size() == 1 && var_childs[0]->GetKind() == ASTNode::NodeKind::NUMBER) {
+                length = bit::getValue<int32_t>(reinterpret_cast<Number *>(var_childs[0].get())->getValue());
+            }
+            auto [it, inserted] = arr_lengths_.insert({var->GetName(), length});
+            if (!inserted && it->second != length) {
+                it->second = -1;
+            }
+        } else if (var->GetKind() == ASTNode::NodeKind::IDENTIFIER) {
+            arr_lengths_[var->GetName()] = -1;
+        }
+    }
+    for (const auto &child : childs) {
+        collectArrLengths(child.get());
+    }
+}
+
+// Loop of form for (int i = c; i < n; i = i + k;) with constants c >= 0, k > 0, whose body does not assign i,
+// keeps i in [0, n) inside body
+std::optional<std::pair<std::string, int64_t>> Compiler::getLoopBound(const std::unique_ptr<ASTNode> &instr)
+{
+    const auto &init = instr->GetChildrenNodes()[0]->GetChildrenNodes();
+    const auto &cond = instr->GetChildrenNodes()[1]->GetChildrenNodes();
+    const auto &step = instr->GetChildrenNodes()[2]->GetChildrenNodes();
+    const auto &stmts = instr->GetChildrenNodes()[3];
+
+    if (init.size() != 2 || init[0]->GetKind() != ASTNode::NodeKind::IDENTIFIER) {
+        return std::nullopt;
+    }
+    const auto &var = init[0]->GetName();
+    auto start = getIntConst(init[1].get());
+    if (!start || *start < 0) {
+        return std::nullopt;
+    }
+
+    if (instr->GetChildrenNodes()[1]->GetName() != "<" || cond.size() != 2 ||
+        cond[0]->GetKind() != ASTNode::NodeKind::IDENTIFIER || cond[0]->GetName() != var) {
+        return std::nullopt;
+    }
+    auto bound = getIntConst(cond[1].get());
+    if (!bound) {
+        return std::nullopt;
+    }
+
+    if (step.size() != 2 || step[0]->GetName() != var || step[1]->GetName() != "+") {
+        return std::nullopt;
+    }
+    const auto &inc = step[1]->GetChildrenNodes();
+    if (inc.size() != 2 || inc[0]->GetKind() != ASTNode::NodeKind::IDENTIFIER || inc[0]->GetName() != var) {
+        return std::nullopt;
+    }
+    auto inc_size = getIntConst(inc[1].get());
+    // Increment must not wrap i around before it reaches bound
+    if (!inc_size || *inc_size <= 0 || *bound + *inc_size > std::numeric_limits<int32_t>::max()) {
+        return std::nullopt;
+    }
+
+    if (isAssigned(stmts.get(), var)) {
+        return std::nullopt;
+    }
+    return std::make_pair(var, *bound);
+}
+
+// Index is induction variable of enclosing loop bounded by length of array
+bool Compiler::isIndexInBounds(const std::unique_ptr<ASTNode> &arr)
+{
+    const auto &idx = arr->GetChildrenNodes()[0];
+    if (idx->GetChildrenNodes().size() != 1) {
+        return false;
+    }
+    const auto &var = idx->GetChildrenNodes()[0]->GetName();
+    auto bound = loop_bounds_.find(var);
+    auto length = arr_lengths_.find(arr->GetName());
+    if (!isVariable(idx.get(), var) || bound == loop_bounds_.end() || length == arr_lengths_.end()) {
+        return false;
+    }
+    return length->second >= 0 && bound->second <= length->second;
+}
+
 void Compiler::compileForStmt(const std::unique_ptr<ASTNode> &instr)
 {
     auto &instrs = curr_func_->getInstrs();
@@ -169,7 +316,14 @@ void Compiler::compileForStmt(const std::unique_ptr<ASTNode> &instr)
     uint64_t pre_body = curr_offset_;
     curr_offset_ += jmp_instr_end.getByteSize();
 
+    auto loop_bound = getLoopBound(instr);
+    if (loop_bound) {
+        loop_bounds_.insert(*loop_bound);
+    }
     compileStatements(stmts.get());
+    if (loop_bound) {
+        loop_bounds_.erase(loop_bound->first);
+    }
 
     compileVarDecl(step);
     auto jmp_instr_start = assembler::Instr<InstrOpcode::JUMP>(0);
@@ -282,14 +436,23 @@ void Compiler::compileArrStore(const std::unique_ptr<ASTNode> &expr, const std::
     auto load_instr = assembler::Instr<InstrOpcode::LDA>(curr_func_->getRegMap()[need_to_assign].first);
     instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::LDA>>(load_instr));
     curr_offset_ += load_instr.getByteSize();
-    if (type == ValueType::INT) {
-        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_I32>(curr_func_->getRegMap()[expr->GetName()].first,
-                                                                       curr_func_->getRegMap()[tmp_for_idx].first);
+    auto arr_reg = curr_func_->getRegMap()[expr->GetName()].first;
+    auto idx_reg = curr_func_->getRegMap()[tmp_for_idx].first;
+    bool in_bounds = isIndexInBounds(expr);
+    if (type == ValueType::INT && in_bounds) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_I32_NC>(arr_reg, idx_reg);
+        instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_STA_I32_NC>>(asm_op_instr));
+        curr_offset_ += asm_op_instr.getByteSize();
+    } else if (type == ValueType::INT) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_I32>(arr_reg, idx_reg);
         instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_STA_I32>>(asm_op_instr));
         curr_offset_ += asm_op_instr.getByteSize();
+    } else if (type == ValueType::FLOAT && in_bounds) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_F_NC>(arr_reg, idx_reg);
+        instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_STA_F_NC>>(asm_op_instr));
+        curr_offset_ += asm_op_instr.getByteSize();
     } else if (type == ValueType::FLOAT) {
-        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_F>(curr_func_->getRegMap()[expr->GetName()].first,
-                                                                     curr_func_->getRegMap()[tmp_for_idx].first);
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_STA_F>(arr_reg, idx_reg);
         instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_STA_F>>(asm_op_instr));
         curr_offset_ += asm_op_instr.getByteSize();
     }
@@ -303,14 +466,23 @@ void Compiler::compileArrLoad(const std::unique_ptr<ASTNode> &expr, const std::s
     auto *arr = reinterpret_cast<Array *>(expr.get());
     auto type = arr->getType();
 
-    if (type == ValueType::INT) {
-        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_I32>(curr_func_->getRegMap()[expr->GetName()].first,
-                                                                       curr_func_->getRegMap()[tmp_for_idx].first);
+    auto arr_reg = curr_func_->getRegMap()[expr->GetName()].first;
+    auto idx_reg = curr_func_->getRegMap()[tmp_for_idx].first;
+    bool in_bounds = isIndexInBounds(expr);
+    if (type == ValueType::INT && in_bounds) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_I32_NC>(arr_reg, idx_reg);
+        instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_LDA_I32_NC>>(asm_op_instr));
+        curr_offset_ += asm_op_instr.getByteSize();
+    } else if (type == ValueType::INT) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_I32>(arr_reg, idx_reg);
         instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_LDA_I32>>(asm_op_instr));
         curr_offset_ += asm_op_instr.getByteSize();
+    } else if (type == ValueType::FLOAT && in_bounds) {
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_F_NC>(arr_reg, idx_reg);
+        instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_LDA_F_NC>>(asm_op_instr));
+        curr_offset_ += asm_op_instr.getByteSize();
     } else if (type == ValueType::FLOAT) {
-        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_F>(curr_func_->getRegMap()[expr->GetName()].first,
-                                                                     curr_func_->getRegMap()[tmp_for_idx].first);
+        auto asm_op_instr = assembler::Instr<InstrOpcode::ARR_LDA_F>(arr_reg, idx_reg);
         instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::ARR_LDA_F>>(asm_op_instr));
         curr_offset_ += asm_op_instr.getByteSize();
     }
@@ -495,6 +667,13 @@ void Compiler::compileArithm(const std::unique_ptr<ASTNode> &expr, const std::st
             curr_func_->getRegMap().insert({child_name, {curr_func_->getRegMap().size(), child_number->getType()}});
             child->setName(child_name);
             compileExpr(child, child_name);
+        } else if (child->GetKind() == ASTNode::NodeKind::ARRAY) {
+            auto *arr = reinterpret_cast<Array *>(child.get());
+            std::string child_name = child == expr->GetChildrenNodes()[0] ? "<tmp_arr_l" : "<tmp_arr_r";
+            child_name += arr->getType() == ValueType::FLOAT ? "_f>" : "_i>";
+            curr_func_->getRegMap().insert({child_name, {curr_func_->getRegMap().size(), arr->getType()}});
+            compileExpr(child, child_name);
+            child->setName(child_name);
         } else if (child->GetKind() == ASTNode::NodeKind::EXPR) {
             if (child->GetChildrenNodes().size() == 1) {
                 auto *child_of_child = child->GetChildrenNodes()[0].get();
@@ -512,6 +691,14 @@ void Compiler::compileArithm(const std::unique_ptr<ASTNode> &expr, const std::st
                     auto child_name = child_of_child->GetName();
                     child->setName(child_name);
                     compileExpr(child, child_name);
+                } else if (child_of_child->GetKind() == ASTNode::NodeKind::ARRAY) {
+                    // Register per operand side and element type, operation type is taken from register
+                    auto *arr = reinterpret_cast<Array *>(child_of_child);
+                    std::string child_name = child == expr->GetChildrenNodes()[0] ? "<tmp_arr_l" : "<tmp_arr_r";
+                    child_name += arr->getType() == ValueType::FLOAT ? "_f>" : "_i>";
+                    curr_func_->getRegMap().insert({child_name, {curr_func_->getRegMap().size(), arr->getType()}});
+                    child->setName(child_name);
+                    compileExpr(child, child_name);
                 }
             }
         }
@@ -663,9 +850,22 @@ void Compiler::compileExpr(const std::unique_ptr<ASTNode> &expr, const std::stri
                     curr_offset_ += asm_instr.getByteSize();
                     break;
                 }
-                default:
-                    std::abort();
+                default: {
+                    // Pass arguments in top registers of window: callee window starts at them
+                    // and does not overlap any caller's locals
+                    R8Id arg_start = std::numeric_limits<R8Id>::max() - args.size() + 1;
+                    for (size_t i = 0; i < args.size(); i++) {
+                        auto mov_instr = assembler::Instr<InstrOpcode::MOV>(curr_func_->getRegMap()[args[i]].first,
+                                                                            arg_start + i);
+                        instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::MOV>>(mov_instr));
+                        curr_offset_ += mov_instr.getByteSize();
+                    }
+                    auto asm_instr =
+                        assembler::Instr<InstrOpcode::CALL_RANGE>(funcName_to_id_[func_name], arg_start, args.size());
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::CALL_RANGE>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
                     break;
+                }
             }
         } else {
             auto &args = funcCall->getArgs();
@@ -733,12 +933,71 @@ void Compiler::compileExpr(const std::unique_ptr<ASTNode> &expr, const std::stri
                     curr_offset_ += asm_instr.getByteSize();
                     break;
                 }
+                case ASTNode::IntrinsicType::ARR_FILL: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_FILL), curr_func_->getRegMap()[args[0]].first,
+                        curr_func_->getRegMap()[args[1]].first, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_COPY: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_COPY), curr_func_->getRegMap()[args[0]].first,
+                        curr_func_->getRegMap()[args[1]].first, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_SUM: {
+                    auto code = IntrinsicCode::ARR_SUM_I32;
+                    if (curr_func_->getRegMap()[args[0]].second == ValueType::FLOAT) {
+                        code = IntrinsicCode::ARR_SUM_F;
+                    }
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(code), curr_func_->getRegMap()[args[0]].first, 0, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_DOT: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_DOT_F), curr_func_->getRegMap()[args[0]].first,
+                        curr_func_->getRegMap()[args[1]].first, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_AXPY: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_AXPY_F), curr_func_->getRegMap()[args[0]].first,
+                        curr_func_->getRegMap()[args[1]].first, curr_func_->getRegMap()[args[2]].first, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_MIN: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_MIN), curr_func_->getRegMap()[args[0]].first, 0, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
+                case ASTNode::IntrinsicType::ARR_MAX: {
+                    auto asm_instr = assembler::Instr<InstrOpcode::INTRINSIC>(
+                        static_cast<uint8_t>(IntrinsicCode::ARR_MAX), curr_func_->getRegMap()[args[0]].first, 0, 0, 0);
+                    instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::INTRINSIC>>(asm_instr));
+                    curr_offset_ += asm_instr.getByteSize();
+                    break;
+                }
                 default:
                     std::abort();
                     break;
             }
         }
-        if (type != ASTNode::IntrinsicType::PRINT) {
+        // Print and in-place array intrinsics produce no value
+        if (type != ASTNode::IntrinsicType::PRINT && type != ASTNode::IntrinsicType::ARR_FILL &&
+            type != ASTNode::IntrinsicType::ARR_COPY && type != ASTNode::IntrinsicType::ARR_AXPY) {
             auto ret_instr = assembler::Instr<InstrOpcode::STA>(curr_func_->getRegMap()[name].first);
             instrs.emplace_back(std::make_unique<assembler::Instr<InstrOpcode::STA>>(ret_instr));
             curr_offset_ += ret_instr.getByteSize();
@@ -123,6 +123,20 @@ void Lexer::run()
                         tokens_.emplace_back(curr_ident_, TokenType::CONCAT);
                     } else if (curr_ident_ == "intrinsic.substr") {
                         tokens_.emplace_back(curr_ident_, TokenType::SUBSTR);
+                    } else if (curr_ident_ == "intrinsic.fill") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_FILL);
+                    } else if (curr_ident_ == "intrinsic.copy") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_COPY);
+                    } else if (curr_ident_ == "intrinsic.sum") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_SUM);
+                    } else if (curr_ident_ == "intrinsic.dot") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_DOT);
+                    } else if (curr_ident_ == "intrinsic.axpy") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_AXPY);
+                    } else if (curr_ident_ == "intrinsic.min") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_MIN);
+                    } else if (curr_ident_ == "intrinsic.max") {
+                        tokens_.emplace_back(curr_ident_, TokenType::ARR_MAX);
                     } else if (curr_ident_ == "function") {
                         tokens_.emplace_back(curr_ident_, TokenType::FUNCTION);
                     } else if (curr_ident_ == "if") {
@@ -534,6 +534,34 @@ ASTNode::IntrinsicType Parser::parseIntrinsicType(std::string &name)
         return ASTNode::IntrinsicType::SUBSTR;
     }
     token_iter_--;
+    if (term<TokenType::ARR_FILL>(&name)) {
+        return ASTNode::IntrinsicType::ARR_FILL;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_COPY>(&name)) {
+        return ASTNode::IntrinsicType::ARR_COPY;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_SUM>(&name)) {
+        return ASTNode::IntrinsicType::ARR_SUM;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_DOT>(&name)) {
+        return ASTNode::IntrinsicType::ARR_DOT;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_AXPY>(&name)) {
+        return ASTNode::IntrinsicType::ARR_AXPY;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_MIN>(&name)) {
+        return ASTNode::IntrinsicType::ARR_MIN;
+    }
+    token_iter_--;
+    if (term<TokenType::ARR_MAX>(&name)) {
+        return ASTNode::IntrinsicType::ARR_MAX;
+    }
+    token_iter_--;
     return ASTNode::IntrinsicType::NONE;
 }
 
@@ -760,7 +788,7 @@ std::vector<std::string> Parser::funcParamCall()
 {
     std::vector<std::string> funcArgs;
 
-    for (int i = 0; i < 4; i++) {
+    for (size_t i = 0; i < MAX_FUNC_ARGS; i++) {
         std::string name = "";
         if (!term<TokenType::IDENTIFIER>(&name)) {
             token_iter_--;
@@ -784,7 +812,7 @@ std::vector<std::pair<std::string, ValueType>> Parser::funcParamDecl()
 {
     std::vector<std::pair<std::string, ValueType>> funcArgs;
 
-    for (int i = 0; i < 4; i++) {
+    for (size_t i = 0; i < MAX_FUNC_ARGS; i++) {
         std::string type = "";
         if (!term<TokenType::TYPE>(&type)) {
             token_iter_--;
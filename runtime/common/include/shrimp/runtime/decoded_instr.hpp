@@ -0,0 +1,34 @@
+#ifndef SHRIMP_RUNTIME_DECODED_INSTR_HPP
+#define SHRIMP_RUNTIME_DECODED_INSTR_HPP
+
+#include <array>
+#include <cstdint>
+
+#include <shrimp/common/types.hpp>
+
+namespace shrimp::runtime {
+
+// Instruction of threaded code with operands unpacked at load time.
+// Slots meaning is defined per opcode by generated interpreter::Decoded<op>
+struct DecodedInstr final {
+    // Address of instruction handler, bound on interpreter entry
+    const void *handler = nullptr;
+    // Instruction in original bytecode
+    const Byte *raw = nullptr;
+    union {
+        // Immediate value or field id
+        uint64_t imm = 0;
+        // Resolved destination of jump
+        const DecodedInstr *target;
+    };
+    // Function, string, class or intrinsic id
+    uint32_t id = 0;
+    // Register operands
+    std::array<R8Id, 4> regs {};
+};
+
+static_assert(sizeof(DecodedInstr) == 32);
+
+}  // namespace shrimp::runtime
+
+#endif  // SHRIMP_RUNTIME_DECODED_INSTR_HPP
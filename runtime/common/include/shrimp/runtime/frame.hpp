@@ -1,42 +1,61 @@
 #ifndef SHRIMP_RUNTIME_FRAME_HPP
 #define SHRIMP_RUNTIME_FRAME_HPP
 
-#include <memory>
-#include <vector>
+#include <cstdint>
 
+#include <shrimp/runtime/decoded_instr.hpp>
 #include <shrimp/runtime/register.hpp>
 #include <shrimp/common/types.hpp>
 
 namespace shrimp::runtime {
 
-class Frame {
+// Frame record on VM control stack. Register window lives on VM register stack
+// and starts with function arguments
+class Frame final {
 public:
-    explicit Frame(std::shared_ptr<RuntimeFunc> func) : curr_method_(func), regs_(curr_method_->num_of_vregs) {}
-    void setRetPc(const Byte *return_pc) noexcept
+    Frame(const RuntimeFunc *func, RegisterWindow regs, size_t regs_end) noexcept
+        : func_(func), regs_(regs), regs_end_(regs_end)
+    {
+    }
+    void setRetPc(const DecodedInstr *return_pc) noexcept
     {
         return_pc_ = return_pc;
     }
-    const Byte *getRetPc() const noexcept
+    const DecodedInstr *getRetPc() const noexcept
     {
         return return_pc_;
     }
-    Register getReg(size_t idx) const noexcept
+    uint64_t getReg(size_t idx) const noexcept
     {
         return regs_[idx];
     }
-    void setReg(uint64_t val, uint8_t reg_num, bool refMark)
+    RegisterWindow getRegs() const noexcept
+    {
+        return regs_;
+    }
+    void setReg(uint64_t val, uint8_t reg_num) noexcept
+    {
+        regs_[reg_num] = val;
+    }
+    // End of register stack part used by this frame and its callers
+    size_t getRegsEnd() const noexcept
+    {
+        return regs_end_;
+    }
+    uint16_t getNumOfRegs() const noexcept
     {
-        regs_[reg_num].setValue(val, refMark);
+        return func_->num_of_vregs;
     }
     ByteOffset getOffsetToFunc() const noexcept
     {
-        return curr_method_->func_start;
+        return func_->func_start;
     }
 
 private:
-    std::shared_ptr<RuntimeFunc> curr_method_;
-    std::vector<Register> regs_ {};
-    const Byte *return_pc_ = nullptr;
+    const RuntimeFunc *func_ = nullptr;
+    RegisterWindow regs_ {};
+    size_t regs_end_ = 0;
+    const DecodedInstr *return_pc_ = nullptr;
 };
 
 }  // namespace shrimp::runtime
@@ -1,29 +1,31 @@
 #ifndef SHRIMP_RUNTIME_REGISTER_HPP
 #define SHRIMP_RUNTIME_REGISTER_HPP
 
+#include <cstddef>
 #include <cstdint>
 
 namespace shrimp::runtime {
 
-class Register final {
+// Frame registers on VM register stack. Registers hold raw values,
+// references among them are described by compiler emitted stack maps
+class RegisterWindow final {
 public:
-    uint64_t getValue() const
-    {
-        return val_;
-    }
-    void setValue(uint64_t val, bool refMark)
+    RegisterWindow() = default;
+    RegisterWindow(uint64_t *vals, size_t base) noexcept : vals_(vals + base), base_(base) {}
+
+    uint64_t &operator[](size_t idx) const noexcept
     {
-        val_ = val;
-        refMark_ = refMark;
+        return vals_[idx];
     }
-    bool getRefMark() const
+    // Position of r0 on register stack
+    size_t getBase() const noexcept
     {
-        return refMark_;
+        return base_;
     }
 
 private:
-    uint64_t val_ = 0;
-    bool refMark_ = false;
+    uint64_t *vals_ = nullptr;
+    size_t base_ = 0;
 };
 
 }  // namespace shrimp::runtime
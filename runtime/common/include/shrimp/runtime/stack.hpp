@@ -0,0 +1,127 @@
+#ifndef SHRIMP_RUNTIME_STACK_HPP
+#define SHRIMP_RUNTIME_STACK_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <sys/mman.h>
+
+#include <shrimp/runtime/frame.hpp>
+#include <shrimp/runtime/register.hpp>
+#include <shrimp/common/types.hpp>
+
+namespace shrimp::runtime {
+
+// VM stack reserved as one region: frame records and register values.
+// Call and return are pointer bumps.
+// Callee window may overlap caller's one, so caller's outgoing argument
+// registers become callee's incoming arguments without copying
+class Stack final {
+public:
+    Stack(size_t max_frames, size_t max_regs)
+        : max_frames_(max_frames),
+          max_regs_(max_regs),
+          size_(max_frames_ * sizeof(Frame) + max_regs_ * sizeof(uint64_t))
+    {
+        void *mem = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) {
+            std::cerr << "Failed to reserve VM stack" << std::endl;
+            std::abort();
+        }
+        frames_begin_ = static_cast<Frame *>(mem);
+        frames_top_ = frames_begin_;
+        vals_ = reinterpret_cast<uint64_t *>(frames_begin_ + max_frames_);
+    }
+
+    ~Stack()
+    {
+        munmap(frames_begin_, size_);
+    }
+
+    Stack(const Stack &) = delete;
+    Stack(Stack &&) = delete;
+
+    Stack &operator=(const Stack &) = delete;
+    Stack &operator=(Stack &&) = delete;
+
+    // Push frame with fresh register window placed after all used ones
+    Frame &push(const RuntimeFunc &func)
+    {
+        return pushWindow(func, getNumOfUsedRegs(), 0);
+    }
+
+    // Push frame with register window started from current frame's arg_start
+    // register. First num_args registers are passed as callee arguments
+    Frame &push(const RuntimeFunc &func, R8Id arg_start, size_t num_args)
+    {
+        return pushWindow(func, top().getRegs().getBase() + arg_start, num_args);
+    }
+
+    void pop() noexcept
+    {
+        --frames_top_;
+    }
+
+    Frame &top() noexcept
+    {
+        return frames_top_[-1];
+    }
+
+    bool empty() const noexcept
+    {
+        return frames_top_ == frames_begin_;
+    }
+
+    Frame *begin() noexcept
+    {
+        return frames_begin_;
+    }
+
+    Frame *end() noexcept
+    {
+        return frames_top_;
+    }
+
+    // Registers of all live frames occupy [0, getNumOfUsedRegs()) of register stack
+    size_t getNumOfUsedRegs() noexcept
+    {
+        return empty() ? 0 : top().getRegsEnd();
+    }
+
+private:
+    Frame &pushWindow(const RuntimeFunc &func, size_t base, size_t num_args)
+    {
+        size_t window_end = base + func.num_of_vregs;
+        if (frames_top_ == frames_begin_ + max_frames_ || window_end > max_regs_) [[unlikely]] {
+            std::cerr << "VM stack overflow" << std::endl;
+            std::abort();
+        }
+        size_t used_end = std::max(window_end, getNumOfUsedRegs());
+        clearRegs(base + num_args, window_end);
+        auto *frame = new (frames_top_++) Frame {&func, RegisterWindow {vals_, base}, used_end};
+        return *frame;
+    }
+
+    // Zero values of registers [begin, end)
+    void clearRegs(size_t begin, size_t end) noexcept
+    {
+        if (begin >= end) {
+            return;
+        }
+        std::memset(vals_ + begin, 0, (end - begin) * sizeof(uint64_t));
+    }
+
+    size_t max_frames_ = 0;
+    size_t max_regs_ = 0;
+    size_t size_ = 0;
+    Frame *frames_begin_ = nullptr;
+    Frame *frames_top_ = nullptr;
+    uint64_t *vals_ = nullptr;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // SHRIMP_RUNTIME_STACK_HPP
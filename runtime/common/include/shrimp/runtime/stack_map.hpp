@@ -0,0 +1,75 @@
+#ifndef SHRIMP_RUNTIME_STACK_MAP_HPP
+#define SHRIMP_RUNTIME_STACK_MAP_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <shrimp/common/types.hpp>
+
+namespace shrimp::runtime {
+
+// Registers of frame suspended at safepoint that hold references.
+// Ambiguous registers hold reference or value depending on taken path
+class StackMap final {
+public:
+    enum class AccKind : uint8_t { VALUE = 0, REF, AMBIGUOUS };
+
+    StackMap() = default;
+    StackMap(const std::vector<R8Id> &refs, const std::vector<R8Id> &ambiguous, AccKind acc_kind)
+        : acc_kind_(acc_kind)
+    {
+        setBits(refs_, refs);
+        setBits(ambiguous_, ambiguous);
+    }
+
+    AccKind getAccKind() const noexcept
+    {
+        return acc_kind_;
+    }
+
+    template <typename Visitor>
+    void forEachRef(Visitor visitor) const
+    {
+        forEachBit(refs_, visitor);
+    }
+
+    template <typename Visitor>
+    void forEachAmbiguous(Visitor visitor) const
+    {
+        forEachBit(ambiguous_, visitor);
+    }
+
+private:
+    static constexpr size_t BITS_PER_WORD = 64;
+    static constexpr size_t NUM_OF_REGS = 256;
+
+    using Bits = std::array<uint64_t, NUM_OF_REGS / BITS_PER_WORD>;
+
+    static void setBits(Bits &bits, const std::vector<R8Id> &regs) noexcept
+    {
+        for (auto reg : regs) {
+            bits[reg / BITS_PER_WORD] |= uint64_t {1} << (reg % BITS_PER_WORD);
+        }
+    }
+
+    template <typename Visitor>
+    static void forEachBit(const Bits &bits, Visitor visitor)
+    {
+        for (size_t word_idx = 0; word_idx < bits.size(); word_idx++) {
+            for (uint64_t word = bits[word_idx]; word != 0; word &= word - 1) {
+                visitor(word_idx * BITS_PER_WORD + std::countr_zero(word));
+            }
+        }
+    }
+
+    Bits refs_ {};
+    Bits ambiguous_ {};
+    AccKind acc_kind_ = AccKind::VALUE;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // SHRIMP_RUNTIME_STACK_MAP_HPP
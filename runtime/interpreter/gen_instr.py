@@ -13,14 +13,44 @@ def write_file_open(out: TextIOWrapper) :
         "#include <array>\n"
         "#include <cstring>\n\n"
 
-        "#include <shrimp/common/instr_opcode.gen.hpp>\n\n"
+        "#include <shrimp/common/instr_opcode.gen.hpp>\n"
+        "#include <shrimp/runtime/decoded_instr.hpp>\n\n"
 
         "namespace shrimp::runtime::interpreter {\n\n"
 
         "template<InstrOpcode op>\n"
         "struct Instr;\n\n"
+
+        "template<InstrOpcode op>\n"
+        "struct Decoded;\n\n"
     )
 
+REG_FIELDS = ["rd", "rs", "rs1", "rs2", "func_arg0", "func_arg1", "func_arg2", "func_arg3", "func_arg_start",
+              "intrinsic_arg_0", "intrinsic_arg_1", "intrinsic_arg_2", "intrinsic_arg_3"]
+IMM_FIELDS = ["imm_i32", "imm_f", "imm_d", "imm_i64", "field_id", "jump_offset", "func_num_args"]
+ID_FIELDS = ["func_id", "str_id", "class_id", "intrinsic_code"]
+
+# Map instruction fields to DecodedInstr slots
+def get_decoded_slots(instr: Instr) -> dict :
+    slots = {}
+    num_regs = 0
+    for field_name in instr.fields.keys() :
+        if field_name in REG_FIELDS :
+            slots[field_name] = "regs[%d]" % num_regs
+            num_regs += 1
+        elif field_name in IMM_FIELDS :
+            slots[field_name] = "imm"
+        elif field_name in ID_FIELDS :
+            slots[field_name] = "id"
+        else :
+            raise RuntimeError("Unknown field in instruction %s: %s" % (instr.name, field_name))
+
+    used = list(slots.values())
+    if num_regs > 4 or len(used) != len(set(used)) :
+        raise RuntimeError("Instruction %s does not fit into DecodedInstr" % instr.name)
+
+    return slots
+
 def write_instr_bin_code(out: TextIOWrapper, size: int) :
     out.write("private:\n")
     out.write("std::array<DWord, %d> bin_code_ {};\n" % size)
@@ -47,12 +77,12 @@ def write_instr_to_string(out: TextIOWrapper, instr: Instr) :
         need_comma = True
 
         match field_name :
-            case "rd" | "rs" | "rs1" | "rs2" | "func_arg0" | "func_arg1" | "func_arg2" | "func_arg3" :
+            case "rd" | "rs" | "rs1" | "rs2" | "func_arg0" | "func_arg1" | "func_arg2" | "func_arg3" | "func_arg_start" :
                 out.write("\"R\" << get%s()" % camel_field_name)
 
             case "imm_i32" :
                 out.write("bit::getValue<int32_t>(get%s())" % camel_field_name)
-            case "imm_i64" | "jump_offset" | "func_id" | "str_id" | "class_id" | "field_id" :
+            case "imm_i64" | "jump_offset" | "func_id" | "str_id" | "class_id" | "field_id" | "func_num_args" :
                 out.write("get%s()" % camel_field_name)
             case "imm_f" :
                 out.write("bit::getValue<float>(get%s())" % camel_field_name)
@@ -96,10 +126,76 @@ def write_instr_spec(out: TextIOWrapper, instr: Instr) :
 
         out.write("}\n\n")
 
+    out.write("// Unpack operands to threaded code instruction\n")
+    out.write("void predecode([[maybe_unused]] DecodedInstr &out) const noexcept {\n")
+    for field_name, slot in get_decoded_slots(instr).items() :
+        out.write("out.%s = get%s();\n" % (slot, name_to_camel(field_name)))
+    out.write("}\n\n")
+
     out.write("private:\n")
     out.write("%s bin_code_ = 0;\n" % instr.size)
     out.write("};\n\n")
 
+def write_decoded_spec(out: TextIOWrapper, instr: Instr) :
+    out.write("template<>\n")
+    out.write("struct Decoded<%s> {\n" % instr.get_opcode_name())
+    out.write(
+        "explicit Decoded(const DecodedInstr *pc) : instr_(pc) {}\n\n"
+
+        "[[nodiscard]] std::string toString() const {\n"
+        "return Instr<%s>(instr_->raw).toString();\n"
+        "}\n\n" % instr.get_opcode_name()
+    )
+
+    for field_name, slot in get_decoded_slots(instr).items() :
+        if field_name == "jump_offset" :
+            out.write("[[nodiscard]] const DecodedInstr *getJumpTarget() const noexcept {\n")
+            out.write("return instr_->target;\n")
+        else :
+            out.write("[[nodiscard]] uint64_t get%s() const noexcept {\n" % name_to_camel(field_name))
+            out.write("return instr_->%s;\n" % slot)
+        out.write("}\n\n")
+
+    out.write("private:\n")
+    out.write("const DecodedInstr *instr_ = nullptr;\n")
+    out.write("};\n\n")
+
+def write_predecode_instr(out: TextIOWrapper, instrs: list) :
+    out.write(
+        "// Unpack instruction at pc. Return instruction size or 0 for invalid opcode\n"
+        "inline size_t predecodeInstr(const Byte *pc, DecodedInstr &out) noexcept {\n"
+        "out.raw = pc;\n"
+        "switch (static_cast<InstrOpcode>(*pc)) {\n"
+    )
+    for instr in instrs :
+        out.write("case %s: {\n" % instr.get_opcode_name())
+        out.write("Instr<%s> instr {pc};\n" % instr.get_opcode_name())
+        out.write("instr.predecode(out);\n")
+        out.write("return instr.getByteSize();\n")
+        out.write("}\n")
+    out.write(
+        "default:\n"
+        "return 0;\n"
+        "}\n"
+        "}\n\n"
+    )
+
+    out.write(
+        "// Check if instruction jump_offset should be resolved to jump target\n"
+        "inline bool isJumpInstr(const Byte *pc) noexcept {\n"
+        "switch (static_cast<InstrOpcode>(*pc)) {\n"
+    )
+    for instr in instrs :
+        if instr.is_jump :
+            out.write("case %s:\n" % instr.get_opcode_name())
+    out.write(
+        "return true;\n"
+        "default:\n"
+        "return false;\n"
+        "}\n"
+        "}\n\n"
+    )
+
 def write_file_close(out: TextIOWrapper) :
     out.write(
         "} // namespace shrimp::runtime::interpreter\n\n"
@@ -120,6 +216,11 @@ if __name__ == "__main__" :
     for instr in instrs :
         write_instr_spec(out, instr)
 
+    for instr in instrs :
+        write_decoded_spec(out, instr)
+
+    write_predecode_instr(out, instrs)
+
     write_file_close(out)
 
     out.close()
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include <shrimp/common/logger.hpp>
 #include <shrimp/common/types.hpp>
 #include <shrimp/runtime/frame.hpp>
 
@@ -10,6 +11,8 @@
 
 namespace shrimp::runtime::interpreter {
 
+// Dispatch loop is instantiated per log level, so instruction tracing is resolved at compile time
+template <LogLevel LOG_LEVEL>
 int runImpl(ShrimpVM *vm);
 
 }  // namespace shrimp::runtime::interpreter
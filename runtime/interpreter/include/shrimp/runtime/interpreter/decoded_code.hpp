@@ -0,0 +1,47 @@
+#ifndef RUNTIME_INTERPRETER_DECODED_CODE_HPP
+#define RUNTIME_INTERPRETER_DECODED_CODE_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <shrimp/common/types.hpp>
+#include <shrimp/runtime/decoded_instr.hpp>
+
+namespace shrimp::runtime::interpreter {
+
+// Threaded code translated from bytecode once at load time
+class DecodedCode final {
+public:
+    explicit DecodedCode(const std::vector<Byte> &code);
+
+    // Get decoded instruction by offset of original instruction in bytecode
+    const DecodedInstr *getInstr(ByteOffset offset) const noexcept
+    {
+        assert(offset_to_idx_[offset] != INVALID_IDX);
+        return instrs_.data() + offset_to_idx_[offset];
+    }
+
+    // Get offset of original instruction in bytecode
+    ByteOffset getOffset(const DecodedInstr *instr) const noexcept
+    {
+        return instr->raw - code_;
+    }
+
+    auto &instrs() noexcept
+    {
+        return instrs_;
+    }
+
+private:
+    static constexpr uint32_t INVALID_IDX = UINT32_MAX;
+
+    const Byte *code_ = nullptr;
+    std::vector<DecodedInstr> instrs_ {};
+    // Index in instrs_ for each bytecode offset where instruction starts
+    std::vector<uint32_t> offset_to_idx_ {};
+};
+
+}  // namespace shrimp::runtime::interpreter
+
+#endif  // RUNTIME_INTERPRETER_DECODED_CODE_HPP
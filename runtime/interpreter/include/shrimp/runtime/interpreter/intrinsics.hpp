@@ -1,22 +1,52 @@
 #ifndef RUNTIME_INTERPRETER_INTRINSICS_HPP
 #define RUNTIME_INTERPRETER_INTRINSICS_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace shrimp::runtime::intrinsics {
 
-void PrintI(int val);
-void PrintF(float val);
-void PrintStr(const std::string &str);
+// Output of print intrinsics, written to stdout when buffer is full, by flush intrinsic,
+// before scan intrinsics and when VM exits
+class OutputBuffer final {
+public:
+    static constexpr size_t CAPACITY = size_t {64} << 10;
+
+    void write(std::string_view str);
+    void flush();
+
+private:
+    std::unique_ptr<char[]> data_ {new char[CAPACITY]};
+    size_t size_ = 0;
+};
+
+void PrintI(OutputBuffer &out, int val);
+void PrintF(OutputBuffer &out, float val);
+void PrintStr(OutputBuffer &out, std::string_view str);
 std::string Concat(const std::string &str1, const std::string &str2);
 std::string Substr(const std::string &str, size_t pos, size_t len);
-int ScanI();
-float ScanF();
+// Pending output is flushed first, so prompts are shown before input is read
+int ScanI(OutputBuffer &out);
+float ScanF(OutputBuffer &out);
 float SinF(float val);
 float CosF(float val);
 float SqrtF(float val);
 
+// Bulk operations over elements of i32 and f arrays, vectorized for instruction set of CPU
+void ArrFill(uint32_t *data, size_t size, uint32_t val);
+void ArrCopy(uint32_t *dst, const uint32_t *src, size_t size);
+int32_t ArrSumI(const int32_t *data, size_t size);
+float ArrSumF(const float *data, size_t size);
+float ArrDotF(const float *x, const float *y, size_t size);
+void ArrAxpyF(float a, const float *x, float *y, size_t size);
+int32_t ArrMinI(const int32_t *data, size_t size);
+int32_t ArrMaxI(const int32_t *data, size_t size);
+float ArrMinF(const float *data, size_t size);
+float ArrMaxF(const float *data, size_t size);
+
 }  // namespace shrimp::runtime::intrinsics
 
 #endif  // RUNTIME_INTERPRETER_INTRINSICS_HPP
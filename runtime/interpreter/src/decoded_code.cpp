@@ -0,0 +1,47 @@
+#include <iostream>
+#include <sstream>
+
+#include <shrimp/common/bitops.hpp>
+#include <shrimp/runtime/interpreter/decoded_code.hpp>
+#include <shrimp/runtime/interpreter/instr.gen.hpp>
+
+namespace shrimp::runtime::interpreter {
+
+// Invalid opcode, terminates threaded code
+static constexpr Byte CODE_END = 0;
+
+DecodedCode::DecodedCode(const std::vector<Byte> &code)
+    : code_(code.data()), offset_to_idx_(code.size() + 1, INVALID_IDX)
+{
+    ByteOffset offset = 0;
+    auto code_size = static_cast<ByteOffset>(code.size());
+    while (offset < code_size) {
+        DecodedInstr instr {};
+        auto instr_size = predecodeInstr(code.data() + offset, instr);
+        if (instr_size == 0 || offset + static_cast<ByteOffset>(instr_size) > code_size) {
+            std::cerr << "Invalid instruction at offset " << offset << std::endl;
+            std::abort();
+        }
+        offset_to_idx_[offset] = instrs_.size();
+        instrs_.push_back(instr);
+        offset += instr_size;
+    }
+
+    // Running off the end of code hits invalid opcode handler
+    offset_to_idx_[offset] = instrs_.size();
+    instrs_.push_back(DecodedInstr {nullptr, &CODE_END, {}, 0, {}});
+
+    for (auto &instr : instrs_) {
+        if (!isJumpInstr(instr.raw)) {
+            continue;
+        }
+        auto dst = static_cast<int64_t>(instr.raw - code.data()) + static_cast<int64_t>(instr.imm);
+        if (dst < 0 || dst > code_size || offset_to_idx_[dst] == INVALID_IDX) {
+            std::cerr << "Invalid jump destination at offset " << instr.raw - code.data() << std::endl;
+            std::abort();
+        }
+        instr.target = instrs_.data() + offset_to_idx_[dst];
+    }
+}
+
+}  // namespace shrimp::runtime::interpreter
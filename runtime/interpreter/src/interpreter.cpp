@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <bit>
 #include <cassert>
 #include <cstdint>
@@ -49,6 +50,14 @@ std::string Instr<InstrOpcode::INTRINSIC>::toString() const
             out << "SUBSTR, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1();
             break;
 
+        case IntrinsicCode::STR_INTERN:
+            out << "STR.INTERN, R" << getIntrinsicArg0();
+            break;
+
+        case IntrinsicCode::STR_EQ:
+            out << "STR.EQ, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1();
+            break;
+
         case IntrinsicCode::SCAN_I32:
             out << "SCAN.I32";
             break;
@@ -57,6 +66,10 @@ std::string Instr<InstrOpcode::INTRINSIC>::toString() const
             out << "SCAN.F";
             break;
 
+        case IntrinsicCode::FLUSH:
+            out << "FLUSH";
+            break;
+
         case IntrinsicCode::COS:
             out << "COS, R" << getIntrinsicArg0();
             break;
@@ -69,6 +82,39 @@ std::string Instr<InstrOpcode::INTRINSIC>::toString() const
             out << "SQRT, R" << getIntrinsicArg0();
             break;
 
+        case IntrinsicCode::ARR_FILL:
+            out << "ARR.FILL, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1();
+            break;
+
+        case IntrinsicCode::ARR_COPY:
+            out << "ARR.COPY, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1();
+            break;
+
+        case IntrinsicCode::ARR_SUM_I32:
+            out << "ARR.SUM.I32, R" << getIntrinsicArg0();
+            break;
+
+        case IntrinsicCode::ARR_SUM_F:
+            out << "ARR.SUM.F, R" << getIntrinsicArg0();
+            break;
+
+        case IntrinsicCode::ARR_DOT_F:
+            out << "ARR.DOT.F, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1();
+            break;
+
+        case IntrinsicCode::ARR_AXPY_F:
+            out << "ARR.AXPY.F, R" << getIntrinsicArg0() << ", R" << getIntrinsicArg1() << ", R"
+                << getIntrinsicArg2();
+            break;
+
+        case IntrinsicCode::ARR_MIN:
+            out << "ARR.MIN, R" << getIntrinsicArg0();
+            break;
+
+        case IntrinsicCode::ARR_MAX:
+            out << "ARR.MAX, R" << getIntrinsicArg0();
+            break;
+
         default:
             assert(0);
     }
@@ -83,459 +129,589 @@ Byte getOpcode(const Byte *pc)
     return *pc & OPCODE_MASK;
 }
 
+// Trap of failed array bounds check, kept out of handlers
+[[gnu::cold]] static int reportOutOfBounds(ShrimpVM *vm, const DecodedInstr *pc, uint32_t pos, uint32_t size)
+{
+    std::cerr << "Array index " << static_cast<int32_t>(pos) << " is out of bounds of array of size " << size
+              << " at offset " << vm->getDecodedCode().getOffset(pc) << std::endl;
+    return -1;
+}
+
+// Trap of array intrinsic applied to array of element type its kernel does not expect
+[[gnu::cold]] static int reportWrongElemType(ShrimpVM *vm, const DecodedInstr *pc)
+{
+    std::cerr << "Intrinsic " << Instr<InstrOpcode::INTRINSIC>(pc->raw).toString()
+              << " does not accept element type of array at offset "
+              << vm->getDecodedCode().getOffset(pc) << std::endl;
+    return -1;
+}
+
+template <LogLevel LOG_LEVEL>
 int runImpl(ShrimpVM *vm)
 {
 #include <shrimp/runtime/interpreter/dispatch_table.gen.inl>
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    // Thread decoded code through handlers of this instantiation
+    for (auto &instr : vm->getDecodedCode().instrs()) {
+        auto opcode = getOpcode(instr.raw);
+        instr.handler = opcode < std::size(dispatch_table) ? dispatch_table[opcode] : &&handleInvalidOpcode;
+    }
+
+    // Interpreter state is cached in locals and written back to vm at safepoints:
+    // calls, returns, allocations, intrinsics and exit
+    const DecodedInstr *pc = vm->pc();
+    uint64_t acc = vm->acc();
+    RegisterWindow regs = vm->currFrame().getRegs();
+
+    auto saveState = [&]() {
+        vm->pc() = pc;
+        vm->acc() = acc;
+    };
+
+    // Allocation safepoint, GC may move object referenced from accumulator
+    auto triggerGCIfNeed = [&]() {
+        saveState();
+        vm->triggerGCIfNeed();
+        acc = vm->acc();
+    };
+
+    goto *pc->handler;
 
 handleInvalidOpcode : {
+    saveState();
     return -1;
 }
 handleNop : {
-    Instr<InstrOpcode::NOP> instr {vm->pc()};
+    Decoded<InstrOpcode::NOP> instr {pc};
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMov : {
-    auto instr = Instr<InstrOpcode::MOV>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MOV>(pc);
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto rs_reg = frame.getReg(rs_idx);
-    auto res = rs_reg.getValue();
-    frame.setReg(res, rd_idx, rs_reg.getRefMark());
+    regs[rd_idx] = regs[rs_idx];
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMovImmI32 : {
-    auto instr = Instr<InstrOpcode::MOV_IMM_I32>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MOV_IMM_I32>(pc);
     auto rd_idx = instr.getRd();
     auto imm_i32 = bit::getValue<int32_t>(instr.getImmI32());
 
-    frame.setReg(imm_i32, rd_idx, false);
+    regs[rd_idx] = imm_i32;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMovImmF : {
-    auto instr = Instr<InstrOpcode::MOV_IMM_F>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MOV_IMM_F>(pc);
     auto rd_idx = instr.getRd();
     auto imm_f = bit::getValue<float>(instr.getImmF());
 
-    frame.setReg(bit::castToWritable(imm_f), rd_idx, false);
+    regs[rd_idx] = bit::castToWritable(imm_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleLda : {
-    auto instr = Instr<InstrOpcode::LDA>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::LDA>(pc);
     auto rs_idx = instr.getRs();
 
-    auto res_reg = frame.getReg(rs_idx);
-    auto res = res_reg.getValue();
-    vm->acc().setValue(res, res_reg.getRefMark());
+    acc = regs[rs_idx];
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleLdaImmI32 : {
-    auto instr = Instr<InstrOpcode::LDA_IMM_I32>(vm->pc());
+    auto instr = Decoded<InstrOpcode::LDA_IMM_I32>(pc);
     auto imm_i32 = bit::getValue<int32_t>(instr.getImmI32());
 
-    vm->acc().setValue(imm_i32, false);
+    acc = imm_i32;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleLdaImmF : {
-    auto instr = Instr<InstrOpcode::LDA_IMM_F>(vm->pc());
+    auto instr = Decoded<InstrOpcode::LDA_IMM_F>(pc);
     auto imm_f = bit::getValue<float>(instr.getImmF());
 
-    vm->acc().setValue(bit::castToWritable(imm_f), false);
+    acc = bit::castToWritable(imm_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleSta : {
-    auto instr = Instr<InstrOpcode::STA>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::STA>(pc);
     auto rd_idx = instr.getRd();
 
-    auto acc = vm->acc();
-    auto res = acc.getValue();
-    frame.setReg(res, rd_idx, acc.getRefMark());
+    regs[rd_idx] = acc;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleAddI32 : {
-    auto instr = Instr<InstrOpcode::ADD_I32>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ADD_I32>(pc);
     auto rs_idx = instr.getRs();
 
-    int32_t acc_i32 = vm->acc().getValue();
-    int32_t rs_i32 = frame.getReg(rs_idx).getValue();
-    vm->acc().setValue(acc_i32 + rs_i32, false);
+    int32_t acc_i32 = acc;
+    int32_t rs_i32 = regs[rs_idx];
+    acc = acc_i32 + rs_i32;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleAddF : {
-    auto instr = Instr<InstrOpcode::ADD_F>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ADD_F>(pc);
     auto rs_idx = instr.getRs();
 
-    auto acc = vm->acc().getValue();
-    auto rs = frame.getReg(rs_idx).getValue();
-    float acc_f = bit::getValue<float>(acc);
+    auto acc_raw = acc;
+    auto rs = regs[rs_idx];
+    float acc_f = bit::getValue<float>(acc_raw);
     float rs_f = bit::getValue<float>(rs);
-    vm->acc().setValue(bit::castToWritable<float>(acc_f + rs_f), false);
+    acc = bit::castToWritable<float>(acc_f + rs_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleSubI32 : {
-    auto instr = Instr<InstrOpcode::SUB_I32>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::SUB_I32>(pc);
     auto rs_idx = instr.getRs();
 
-    int32_t acc_i32 = vm->acc().getValue();
-    int32_t rs_i32 = frame.getReg(rs_idx).getValue();
-    vm->acc().setValue(bit::castToWritable(acc_i32 - rs_i32), false);
+    int32_t acc_i32 = acc;
+    int32_t rs_i32 = regs[rs_idx];
+    acc = bit::castToWritable(acc_i32 - rs_i32);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleSubF : {
-    auto instr = Instr<InstrOpcode::SUB_F>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::SUB_F>(pc);
     auto rs_idx = instr.getRs();
 
-    auto acc = vm->acc().getValue();
-    auto rs = frame.getReg(rs_idx).getValue();
-    auto acc_f = bit::getValue<float>(acc);
+    auto acc_raw = acc;
+    auto rs = regs[rs_idx];
+    auto acc_f = bit::getValue<float>(acc_raw);
     auto rs_f = bit::getValue<float>(rs);
-    vm->acc().setValue(bit::castToWritable(acc_f - rs_f), false);
+    acc = bit::castToWritable(acc_f - rs_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMod : {
-    auto instr = Instr<InstrOpcode::MOD>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MOD>(pc);
     auto rs_idx = instr.getRs();
 
-    int32_t acc_i32 = vm->acc().getValue();
-    int32_t rs_i32 = frame.getReg(rs_idx).getValue();
+    int32_t acc_i32 = acc;
+    int32_t rs_i32 = regs[rs_idx];
     auto res = bit::signExtend<DWord, 31>(acc_i32 % rs_i32);
-    vm->acc().setValue(bit::castToWritable(res), false);
+    acc = bit::castToWritable(res);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleDivI32 : {
-    auto instr = Instr<InstrOpcode::DIV_I32>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::DIV_I32>(pc);
     auto rs_idx = instr.getRs();
 
-    int32_t acc_i32 = vm->acc().getValue();
-    int32_t rs_i32 = frame.getReg(rs_idx).getValue();
+    int32_t acc_i32 = acc;
+    int32_t rs_i32 = regs[rs_idx];
     auto res = bit::signExtend<DWord, 31>(acc_i32 / rs_i32);
-    vm->acc().setValue(bit::castToWritable(res), false);
+    acc = bit::castToWritable(res);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleDivF : {
-    auto instr = Instr<InstrOpcode::DIV_F>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::DIV_F>(pc);
     auto rs_idx = instr.getRs();
 
-    auto acc = vm->acc().getValue();
-    auto rs = frame.getReg(rs_idx).getValue();
-    auto acc_f = bit::getValue<float>(acc);
+    auto acc_raw = acc;
+    auto rs = regs[rs_idx];
+    auto acc_f = bit::getValue<float>(acc_raw);
     auto rs_f = bit::getValue<float>(rs);
-    vm->acc().setValue(bit::castToWritable(acc_f / rs_f), false);
+    acc = bit::castToWritable(acc_f / rs_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMulI32 : {
-    auto instr = Instr<InstrOpcode::MUL_I32>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MUL_I32>(pc);
     auto rs_idx = instr.getRs();
 
-    int32_t acc_i32 = vm->acc().getValue();
-    int32_t rs_i32 = frame.getReg(rs_idx).getValue();
+    int32_t acc_i32 = acc;
+    int32_t rs_i32 = regs[rs_idx];
 
     auto res = bit::signExtend<DWord, 31>(acc_i32 * rs_i32);
-    vm->acc().setValue(bit::castToWritable(res), false);
+    acc = bit::castToWritable(res);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleMulF : {
-    auto instr = Instr<InstrOpcode::MUL_F>(vm->pc());
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::MUL_F>(pc);
     auto rs_idx = instr.getRs();
 
-    auto acc = vm->acc().getValue();
-    auto rs = frame.getReg(rs_idx).getValue();
-    auto acc_f = bit::getValue<float>(acc);
+    auto acc_raw = acc;
+    auto rs = regs[rs_idx];
+    auto acc_f = bit::getValue<float>(acc_raw);
     auto rs_f = bit::getValue<float>(rs);
-    vm->acc().setValue(bit::castToWritable(acc_f * rs_f), false);
+    acc = bit::castToWritable(acc_f * rs_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleIntrinsic : {
-    auto instr = Instr<InstrOpcode::INTRINSIC>(vm->pc());
-    auto &frame = vm->currFrame();
-
+    auto instr = Decoded<InstrOpcode::INTRINSIC>(pc);
     auto intrinsic_code = static_cast<IntrinsicCode>(instr.getIntrinsicCode());
 
     auto arg0_idx = instr.getIntrinsicArg0();
     auto arg1_idx = instr.getIntrinsicArg1();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    saveState();
 
     switch (intrinsic_code) {
         case IntrinsicCode::PRINT_I32: {
-            auto value_raw = frame.getReg(arg0_idx).getValue();
+            auto value_raw = regs[arg0_idx];
             auto value = bit::getValue<int32_t>(value_raw);
 
-            intrinsics::PrintI(value);
+            intrinsics::PrintI(vm->getOutput(), value);
             break;
         }
         case IntrinsicCode::PRINT_F: {
-            auto value_raw = frame.getReg(arg0_idx).getValue();
+            auto value_raw = regs[arg0_idx];
             auto value = bit::getValue<float>(value_raw);
 
-            intrinsics::PrintF(value);
+            intrinsics::PrintF(vm->getOutput(), value);
             break;
         }
         case IntrinsicCode::PRINT_STR: {
-            auto ptr = frame.getReg(arg0_idx).getValue();
-            auto strObj = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr));
-            const std::string &str = strObj->getData();
+            // Rope is flattened for printing
+            triggerGCIfNeed();
+            auto ptr = regs[arg0_idx];
+            auto strObj = String::Flatten(reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr)), vm);
 
-            intrinsics::PrintStr(str);
+            intrinsics::PrintStr(vm->getOutput(), {strObj->getData(), strObj->getSize()});
             break;
         }
         case IntrinsicCode::CONCAT: {
-            vm->triggerGCIfNeed();
-            auto ptr0 = frame.getReg(arg0_idx).getValue();
+            triggerGCIfNeed();
+            auto ptr0 = regs[arg0_idx];
             auto strObj0 = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr0));
-            auto ptr1 = frame.getReg(arg1_idx).getValue();
+            auto ptr1 = regs[arg1_idx];
             auto strObj1 = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr1));
 
             auto strObj = String::ConcatStrings(strObj0, strObj1, vm);
 
             auto ptr = std::bit_cast<int32_t *>(strObj);
 
-            vm->acc().setValue(bit::castToWritable(ptr), true);
+            acc = bit::castToWritable(ptr);
             break;
         }
         case IntrinsicCode::SUBSTR: {
-            vm->triggerGCIfNeed();
-            auto pos = frame.getReg(arg0_idx).getValue();
-            auto len = frame.getReg(arg1_idx).getValue();
-            auto ptr = vm->acc().getValue();
+            triggerGCIfNeed();
+            auto pos = regs[arg0_idx];
+            auto len = regs[arg1_idx];
+            auto ptr = acc;
             auto strObj = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr));
 
             auto newStrObj = String::SubStr(strObj, pos, len, vm);
 
             auto newPtr = std::bit_cast<int32_t *>(newStrObj);
-            vm->acc().setValue(bit::castToWritable(newPtr), true);
+            acc = bit::castToWritable(newPtr);
 
             break;
         }
+        case IntrinsicCode::STR_INTERN: {
+            triggerGCIfNeed();
+            auto ptr = regs[arg0_idx];
+            auto strObj = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr));
+
+            auto internedObj = String::Intern(strObj, vm);
+
+            acc = bit::castToWritable(std::bit_cast<int32_t *>(internedObj));
+            break;
+        }
+        case IntrinsicCode::STR_EQ: {
+            triggerGCIfNeed();
+            auto ptr0 = regs[arg0_idx];
+            auto strObj0 = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr0));
+            auto ptr1 = regs[arg1_idx];
+            auto strObj1 = reinterpret_cast<String *>(bit::getValue<int32_t *>(ptr1));
+
+            acc = bit::castToWritable(static_cast<int32_t>(String::IsEqual(strObj0, strObj1, vm)));
+            break;
+        }
         case IntrinsicCode::SCAN_I32: {
-            auto res = intrinsics::ScanI();
+            auto res = intrinsics::ScanI(vm->getOutput());
 
-            vm->acc().setValue(bit::castToWritable(res), false);
+            acc = bit::castToWritable(res);
             break;
         }
         case IntrinsicCode::SCAN_F: {
-            auto res = intrinsics::ScanF();
+            auto res = intrinsics::ScanF(vm->getOutput());
 
-            vm->acc().setValue(bit::castToWritable(res), false);
+            acc = bit::castToWritable(res);
             break;
         }
+        case IntrinsicCode::FLUSH:
+            vm->getOutput().flush();
+            break;
         case IntrinsicCode::SIN: {
-            auto value_raw = frame.getReg(arg0_idx).getValue();
+            auto value_raw = regs[arg0_idx];
             auto value = bit::getValue<float>(value_raw);
 
             auto res = intrinsics::SinF(value);
-            vm->acc().setValue(bit::castToWritable(res), false);
+            acc = bit::castToWritable(res);
             break;
         }
         case IntrinsicCode::COS: {
-            auto value_raw = frame.getReg(arg0_idx).getValue();
+            auto value_raw = regs[arg0_idx];
             auto value = bit::getValue<float>(value_raw);
 
             auto res = intrinsics::CosF(value);
-            vm->acc().setValue(bit::castToWritable(res), false);
+            acc = bit::castToWritable(res);
             break;
         }
         case IntrinsicCode::SQRT: {
-            auto value_raw = frame.getReg(arg0_idx).getValue();
+            auto value_raw = regs[arg0_idx];
             auto value = bit::getValue<float>(value_raw);
 
             auto res = intrinsics::SqrtF(value);
-            vm->acc().setValue(bit::castToWritable(res), false);
+            acc = bit::castToWritable(res);
+            break;
+        }
+        // Bulk array intrinsics work on i32 and f arrays, reference arrays would need write barrier per element
+        case IntrinsicCode::ARR_FILL: {
+            auto arrObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            if (arrObj->getElemType() == ArrayElemType::REF) {
+                return reportWrongElemType(vm, pc);
+            }
+            intrinsics::ArrFill(arrObj->getElemAddr<uint32_t>(0), arrObj->getSize(),
+                                bit::getValue<uint32_t>(regs[arg1_idx]));
+            break;
+        }
+        case IntrinsicCode::ARR_COPY: {
+            auto dstObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            auto srcObj = std::bit_cast<Array *>(regs[arg1_idx]);
+            if (dstObj->getElemType() == ArrayElemType::REF || dstObj->getElemType() != srcObj->getElemType()) {
+                return reportWrongElemType(vm, pc);
+            }
+            intrinsics::ArrCopy(dstObj->getElemAddr<uint32_t>(0), srcObj->getElemAddr<uint32_t>(0),
+                                std::min(dstObj->getSize(), srcObj->getSize()));
+            break;
+        }
+        case IntrinsicCode::ARR_SUM_I32: {
+            auto arrObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            if (arrObj->getElemType() != ArrayElemType::I32) {
+                return reportWrongElemType(vm, pc);
+            }
+
+            auto res = intrinsics::ArrSumI(arrObj->getElemAddr<int32_t>(0), arrObj->getSize());
+            acc = bit::castToWritable(res);
+            break;
+        }
+        case IntrinsicCode::ARR_SUM_F: {
+            auto arrObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            if (arrObj->getElemType() != ArrayElemType::F) {
+                return reportWrongElemType(vm, pc);
+            }
+
+            auto res = intrinsics::ArrSumF(arrObj->getElemAddr<float>(0), arrObj->getSize());
+            acc = bit::castToWritable(res);
+            break;
+        }
+        case IntrinsicCode::ARR_DOT_F: {
+            auto xObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            auto yObj = std::bit_cast<Array *>(regs[arg1_idx]);
+            if (xObj->getElemType() != ArrayElemType::F || yObj->getElemType() != ArrayElemType::F) {
+                return reportWrongElemType(vm, pc);
+            }
+
+            auto res = intrinsics::ArrDotF(xObj->getElemAddr<float>(0), yObj->getElemAddr<float>(0),
+                                           std::min(xObj->getSize(), yObj->getSize()));
+            acc = bit::castToWritable(res);
+            break;
+        }
+        case IntrinsicCode::ARR_AXPY_F: {
+            auto a = bit::getValue<float>(regs[arg0_idx]);
+            auto xObj = std::bit_cast<Array *>(regs[arg1_idx]);
+            auto yObj = std::bit_cast<Array *>(regs[instr.getIntrinsicArg2()]);
+            if (xObj->getElemType() != ArrayElemType::F || yObj->getElemType() != ArrayElemType::F) {
+                return reportWrongElemType(vm, pc);
+            }
+
+            intrinsics::ArrAxpyF(a, xObj->getElemAddr<float>(0), yObj->getElemAddr<float>(0),
+                                 std::min(xObj->getSize(), yObj->getSize()));
+            break;
+        }
+        case IntrinsicCode::ARR_MIN:
+        case IntrinsicCode::ARR_MAX: {
+            auto arrObj = std::bit_cast<Array *>(regs[arg0_idx]);
+            bool is_max = intrinsic_code == IntrinsicCode::ARR_MAX;
+
+            switch (arrObj->getElemType()) {
+                case ArrayElemType::I32: {
+                    auto *data = arrObj->getElemAddr<int32_t>(0);
+                    auto res = is_max ? intrinsics::ArrMaxI(data, arrObj->getSize())
+                                      : intrinsics::ArrMinI(data, arrObj->getSize());
+                    acc = bit::castToWritable(res);
+                    break;
+                }
+                case ArrayElemType::F: {
+                    auto *data = arrObj->getElemAddr<float>(0);
+                    auto res = is_max ? intrinsics::ArrMaxF(data, arrObj->getSize())
+                                      : intrinsics::ArrMinF(data, arrObj->getSize());
+                    acc = bit::castToWritable(res);
+                    break;
+                }
+                default:
+                    return reportWrongElemType(vm, pc);
+            }
             break;
         }
         default: {
-            LOG_INFO("Unsupported intrinsic", vm->getLogLevel());
+            LOG_INFO("Unsupported intrinsic", LOG_LEVEL);
             std::abort();
         }
     }
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    // Logs are written to stdout directly, so output is not kept in buffer while they are on
+    if constexpr (LOG_LEVEL != LogLevel::NONE) {
+        vm->getOutput().flush();
+    }
+    ++pc;
+    goto *pc->handler;
 }
 handleCall0arg : {
-    Instr<InstrOpcode::CALL_0ARG> instr {vm->pc()};
+    Decoded<InstrOpcode::CALL_0ARG> instr {pc};
 
     auto func_id = instr.getFuncId();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
-
-    vm->stack().push_back(Frame {std::make_shared<RuntimeFunc>(vm->resolveFunc(func_id))});
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    auto &frame = vm->currFrame();
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id));
+    regs = frame.getRegs();
 
     ByteOffset offset = frame.getOffsetToFunc();
-    frame.setRetPc(vm->pc() + instr.getByteSize());
-    vm->pc() = vm->getPcFromStart(offset);
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    goto *pc->handler;
 }
 handleCall1arg : {
-    Instr<InstrOpcode::CALL_1ARG> instr {vm->pc()};
+    Decoded<InstrOpcode::CALL_1ARG> instr {pc};
 
     auto func_id = instr.getFuncId();
     auto func_0arg_idx = instr.getFuncArg0();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    auto &prev_frame = vm->currFrame();
-    auto reg0 = prev_frame.getReg(func_0arg_idx);
-    vm->stack().push_back(Frame {std::make_shared<RuntimeFunc>(vm->resolveFunc(func_id))});
-    auto &frame = vm->currFrame();
+    auto func_0arg = regs[func_0arg_idx];
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id));
+    regs = frame.getRegs();
 
-    auto func_0arg = reg0.getValue();
-    // TODO(VasiliyMatr): replace magic number to function
-    frame.setReg(func_0arg, 255, reg0.getRefMark());
+    regs[0] = func_0arg;
 
     ByteOffset offset = frame.getOffsetToFunc();
-    frame.setRetPc(vm->pc() + instr.getByteSize());
-    vm->pc() = vm->getPcFromStart(offset);
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    goto *pc->handler;
 }
 handleCall2arg : {
-    Instr<InstrOpcode::CALL_2ARG> instr {vm->pc()};
+    Decoded<InstrOpcode::CALL_2ARG> instr {pc};
 
     auto func_id = instr.getFuncId();
     auto func_0arg_idx = instr.getFuncArg0();
     auto func_1arg_idx = instr.getFuncArg1();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    auto &prev_frame = vm->currFrame();
-    auto reg0 = prev_frame.getReg(func_0arg_idx);
-    auto reg1 = prev_frame.getReg(func_1arg_idx);
-    vm->stack().push_back(Frame {std::make_shared<RuntimeFunc>(vm->resolveFunc(func_id))});
-    auto &frame = vm->currFrame();
+    auto func_0arg = regs[func_0arg_idx];
+    auto func_1arg = regs[func_1arg_idx];
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id));
+    regs = frame.getRegs();
 
-    auto func_0arg = reg0.getValue();
-    auto func_1arg = reg1.getValue();
-    // TODO(VasiliyMatr): replace magic number to function
-    frame.setReg(func_0arg, 255, reg0.getRefMark());
-    frame.setReg(func_1arg, 254, reg1.getRefMark());
+    regs[0] = func_0arg;
+    regs[1] = func_1arg;
 
     ByteOffset offset = frame.getOffsetToFunc();
-    frame.setRetPc(vm->pc() + instr.getByteSize());
-    vm->pc() = vm->getPcFromStart(offset);
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    goto *pc->handler;
 }
 handleCall3arg : {
-    Instr<InstrOpcode::CALL_3ARG> instr {vm->pc()};
+    Decoded<InstrOpcode::CALL_3ARG> instr {pc};
 
     auto func_id = instr.getFuncId();
     auto func_0arg_idx = instr.getFuncArg0();
     auto func_1arg_idx = instr.getFuncArg1();
     auto func_2arg_idx = instr.getFuncArg2();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
-
-    auto &prev_frame = vm->currFrame();
-    auto reg0 = prev_frame.getReg(func_0arg_idx);
-    auto reg1 = prev_frame.getReg(func_1arg_idx);
-    auto reg2 = prev_frame.getReg(func_2arg_idx);
-    vm->stack().push_back(Frame {std::make_shared<RuntimeFunc>(vm->resolveFunc(func_id))});
-    auto &frame = vm->currFrame();
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    auto func_0arg = reg0.getValue();
-    auto func_1arg = reg1.getValue();
-    auto func_2arg = reg2.getValue();
+    auto func_0arg = regs[func_0arg_idx];
+    auto func_1arg = regs[func_1arg_idx];
+    auto func_2arg = regs[func_2arg_idx];
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id));
+    regs = frame.getRegs();
 
-    // TODO(VasiliyMatr): replace magic number to function
-    frame.setReg(func_0arg, 255, reg0.getRefMark());
-    frame.setReg(func_1arg, 254, reg1.getRefMark());
-    frame.setReg(func_2arg, 253, reg2.getRefMark());
+    regs[0] = func_0arg;
+    regs[1] = func_1arg;
+    regs[2] = func_2arg;
 
     ByteOffset offset = frame.getOffsetToFunc();
-    frame.setRetPc(vm->pc() + instr.getByteSize());
-    vm->pc() = vm->getPcFromStart(offset);
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    goto *pc->handler;
 }
 handleCall4arg : {
-    Instr<InstrOpcode::CALL_4ARG> instr {vm->pc()};
+    Decoded<InstrOpcode::CALL_4ARG> instr {pc};
 
     auto func_id = instr.getFuncId();
     auto func_0arg_idx = instr.getFuncArg0();
@@ -543,250 +719,253 @@ handleCall4arg : {
     auto func_2arg_idx = instr.getFuncArg2();
     auto func_3arg_idx = instr.getFuncArg3();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    auto &prev_frame = vm->currFrame();
-    auto reg0 = prev_frame.getReg(func_0arg_idx);
-    auto reg1 = prev_frame.getReg(func_1arg_idx);
-    auto reg2 = prev_frame.getReg(func_2arg_idx);
-    auto reg3 = prev_frame.getReg(func_3arg_idx);
-    vm->stack().push_back(Frame {std::make_shared<RuntimeFunc>(vm->resolveFunc(func_id))});
-    auto &frame = vm->currFrame();
+    auto func_0arg = regs[func_0arg_idx];
+    auto func_1arg = regs[func_1arg_idx];
+    auto func_2arg = regs[func_2arg_idx];
+    auto func_3arg = regs[func_3arg_idx];
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id));
+    regs = frame.getRegs();
+
+    regs[0] = func_0arg;
+    regs[1] = func_1arg;
+    regs[2] = func_2arg;
+    regs[3] = func_3arg;
+
+    ByteOffset offset = frame.getOffsetToFunc();
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    auto func_0arg = reg0.getValue();
-    auto func_1arg = reg1.getValue();
-    auto func_2arg = reg2.getValue();
-    auto func_3arg = reg3.getValue();
+    goto *pc->handler;
+}
+handleCallRange : {
+    Decoded<InstrOpcode::CALL_RANGE> instr {pc};
 
-    // TODO(VasiliyMatr): replace magic number to function
-    frame.setReg(func_0arg, 255, reg0.getRefMark());
-    frame.setReg(func_1arg, 254, reg1.getRefMark());
-    frame.setReg(func_2arg, 253, reg2.getRefMark());
-    frame.setReg(func_3arg, 252, reg3.getRefMark());
+    auto func_id = instr.getFuncId();
+    auto func_arg_start = instr.getFuncArgStart();
+    auto func_num_args = instr.getFuncNumArgs();
+
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    // Arguments are already in place: callee window starts at func_arg_start
+    auto &frame = vm->stack().push(vm->resolveFunc(func_id), func_arg_start, func_num_args);
+    regs = frame.getRegs();
 
     ByteOffset offset = frame.getOffsetToFunc();
-    frame.setRetPc(vm->pc() + instr.getByteSize());
-    vm->pc() = vm->getPcFromStart(offset);
+    frame.setRetPc(pc + 1);
+    pc = vm->getPcFromStart(offset);
+    saveState();
 
-    goto *dispatch_table[getOpcode(vm->pc())];
+    goto *pc->handler;
 }
 handleRet : {
-    Instr<InstrOpcode::RET> instr {vm->pc()};
+    Decoded<InstrOpcode::RET> instr {pc};
     auto &frame = vm->currFrame();
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
     auto *ret_pc = frame.getRetPc();
     if (ret_pc != nullptr) {
-        vm->pc() = ret_pc;
-        vm->stack().pop_back();
-        goto *dispatch_table[getOpcode(vm->pc())];
+        pc = ret_pc;
+        vm->stack().pop();
+        regs = vm->currFrame().getRegs();
+        saveState();
+        goto *pc->handler;
     }
 
+    saveState();
     return 0;
 }
 handleJump : {
-    Instr<InstrOpcode::JUMP> instr {vm->pc()};
-    int64_t offset = instr.getJumpOffset();
+    Decoded<InstrOpcode::JUMP> instr {pc};
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += offset;
-    goto *dispatch_table[getOpcode(vm->pc())];
+    pc = instr.getJumpTarget();
+    goto *pc->handler;
 }
 handleJumpGg : {
-    Instr<InstrOpcode::JUMP_GG> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::JUMP_GG> instr {pc};
     auto rs_idx = instr.getRs();
-    auto offset = instr.getJumpOffset();
 
-    auto gg = bit::getValue<int32_t>(vm->acc().getValue()) > bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto gg = bit::getValue<int32_t>(acc) > bit::getValue<int32_t>(regs[rs_idx]);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += gg ? offset : instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    pc = gg ? instr.getJumpTarget() : pc + 1;
+    goto *pc->handler;
 }
 handleJumpNotEq : {
-    Instr<InstrOpcode::JUMP_EQ> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::JUMP_NOT_EQ> instr {pc};
     auto rs_idx = instr.getRs();
-    auto offset = instr.getJumpOffset();
 
-    auto eq = bit::getValue<int32_t>(vm->acc().getValue()) != bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto eq = bit::getValue<int32_t>(acc) != bit::getValue<int32_t>(regs[rs_idx]);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += eq ? offset : instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    pc = eq ? instr.getJumpTarget() : pc + 1;
+    goto *pc->handler;
 }
 handleJumpEq : {
-    Instr<InstrOpcode::JUMP_EQ> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::JUMP_EQ> instr {pc};
     auto rs_idx = instr.getRs();
-    auto offset = instr.getJumpOffset();
 
-    auto eq = bit::getValue<int32_t>(vm->acc().getValue()) == bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto eq = bit::getValue<int32_t>(acc) == bit::getValue<int32_t>(regs[rs_idx]);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += eq ? offset : instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    pc = eq ? instr.getJumpTarget() : pc + 1;
+    goto *pc->handler;
 }
 handleJumpLl : {
-    Instr<InstrOpcode::JUMP_LL> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::JUMP_LL> instr {pc};
     auto rs_idx = instr.getRs();
-    auto offset = instr.getJumpOffset();
 
-    auto ll = bit::getValue<int32_t>(vm->acc().getValue()) < bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto ll = bit::getValue<int32_t>(acc) < bit::getValue<int32_t>(regs[rs_idx]);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += ll ? offset : instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    pc = ll ? instr.getJumpTarget() : pc + 1;
+    goto *pc->handler;
 }
 handleI32tof : {
-    auto instr = Instr<InstrOpcode::I32TOF>(vm->pc());
+    auto instr = Decoded<InstrOpcode::I32TOF>(pc);
 
-    int32_t acc_i32 = vm->acc().getValue();
+    int32_t acc_i32 = acc;
     float acc_f = acc_i32;
-    vm->acc().setValue(bit::castToWritable(acc_f), false);
+    acc = bit::castToWritable(acc_f);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleFtoi32 : {
-    auto instr = Instr<InstrOpcode::FTOI32>(vm->pc());
+    auto instr = Decoded<InstrOpcode::FTOI32>(pc);
 
-    auto acc = vm->acc().getValue();
-    auto acc_f = bit::getValue<float>(acc);
+    auto acc_raw = acc;
+    auto acc_f = bit::getValue<float>(acc_raw);
     int32_t acc_i = acc_f;
-    vm->acc().setValue(bit::castToWritable(acc_i), false);
+    acc = bit::castToWritable(acc_i);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleLdaStr : {
-    vm->triggerGCIfNeed();
-    auto instr = Instr<InstrOpcode::LDA_STR>(vm->pc());
+    auto instr = Decoded<InstrOpcode::LDA_STR>(pc);
 
     auto str_id = instr.getStrId();
-    const auto &str = vm->resolveString(str_id);
-    auto strObj = String::AllocateString(str.size(), str.data(), vm);
+    auto &interned = vm->getInternedString(str_id);
+    if (interned == 0) [[unlikely]] {
+        triggerGCIfNeed();
+        const auto &str = vm->resolveString(str_id);
+        auto strObj = String::Intern(String::AllocateString(str.size(), str.data(), vm), vm);
+
+        auto ptr = std::bit_cast<int32_t *>(strObj);
 
-    auto ptr = std::bit_cast<int32_t *>(strObj);
+        interned = bit::castToWritable(ptr);
+    }
 
-    vm->acc().setValue(bit::castToWritable(ptr), true);
+    acc = interned;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrLength : {
-    auto instr = Instr<InstrOpcode::ARR_LENGTH>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ARR_LENGTH>(pc);
 
     auto rs_idx = instr.getRs();
 
-    auto arrObj = std::bit_cast<Array *>(frame.getReg(rs_idx).getValue());
+    auto arrObj = std::bit_cast<Array *>(regs[rs_idx]);
 
-    vm->acc().setValue(bit::castToWritable(arrObj->getSize()), false);
+    acc = bit::castToWritable(arrObj->getSize());
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrNewI32 : {
-    vm->triggerGCIfNeed();
-    auto instr = Instr<InstrOpcode::ARR_NEW_I32>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    triggerGCIfNeed();
+    auto instr = Decoded<InstrOpcode::ARR_NEW_I32>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto size = frame.getReg(rs_idx).getValue();
+    auto size = regs[rs_idx];
 
-    auto arrObj = Array::AllocateArray(0, size, vm);
+    auto arrObj = Array::AllocateArray(vm->getArrayClass(ArrayElemType::I32), size, vm);
 
     int32_t *ptr = std::bit_cast<int32_t *>(arrObj);
 
-    frame.setReg(bit::castToWritable(ptr), rd_idx, true);
+    regs[rd_idx] = bit::castToWritable(ptr);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleCmpEqI32 : {
-    Instr<InstrOpcode::CMP_EQ_I32> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::CMP_EQ_I32> instr {pc};
     auto rs_idx = instr.getRs();
 
-    auto eq = bit::getValue<int32_t>(vm->acc().getValue()) == bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto eq = bit::getValue<int32_t>(acc) == bit::getValue<int32_t>(regs[rs_idx]);
 
-    vm->acc().setValue(bit::castToWritable(static_cast<uint32_t>(eq)), false);
+    acc = bit::castToWritable(static_cast<uint32_t>(eq));
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrNewF : {
-    vm->triggerGCIfNeed();
-    auto instr = Instr<InstrOpcode::ARR_NEW_F>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    triggerGCIfNeed();
+    auto instr = Decoded<InstrOpcode::ARR_NEW_F>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto size = frame.getReg(rs_idx).getValue();
+    auto size = regs[rs_idx];
 
-    auto arrObj = Array::AllocateArray(0, size, vm);
+    auto arrObj = Array::AllocateArray(vm->getArrayClass(ArrayElemType::F), size, vm);
 
     int32_t *ptr = std::bit_cast<int32_t *>(arrObj);
 
-    frame.setReg(bit::castToWritable(ptr), rd_idx, true);
+    regs[rd_idx] = bit::castToWritable(ptr);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleCmpGgI32 : {
-    Instr<InstrOpcode::CMP_GG_I32> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::CMP_GG_I32> instr {pc};
     auto rs_idx = instr.getRs();
 
-    auto gg = bit::getValue<int32_t>(vm->acc().getValue()) > bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto gg = bit::getValue<int32_t>(acc) > bit::getValue<int32_t>(regs[rs_idx]);
 
-    vm->acc().setValue(bit::castToWritable(static_cast<uint32_t>(gg)), false);
+    acc = bit::castToWritable(static_cast<uint32_t>(gg));
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrNewRef : {
-    vm->triggerGCIfNeed();
-    auto instr = Instr<InstrOpcode::ARR_NEW_REF>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    triggerGCIfNeed();
+    auto instr = Decoded<InstrOpcode::ARR_NEW_REF>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
     auto class_id = instr.getClassId();
 
-    auto size = frame.getReg(rs_idx).getValue();
+    auto size = regs[rs_idx];
 
     const auto &klass = vm->getClasses()[class_id];
 
@@ -794,169 +973,256 @@ handleArrNewRef : {
 
     int32_t *ptr = std::bit_cast<int32_t *>(arrObj);
 
-    frame.setReg(bit::castToWritable(ptr), rd_idx, true);
+    regs[rd_idx] = bit::castToWritable(ptr);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrLdaI32 : {
-    auto instr = Instr<InstrOpcode::ARR_LDA_I32>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ARR_LDA_I32>(pc);
 
     auto rs1_idx = instr.getRs1();
     auto rs2_idx = instr.getRs2();
 
-    auto pos = frame.getReg(rs2_idx).getValue();
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rs1_idx).getValue());
+    auto pos = static_cast<uint32_t>(regs[rs2_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rs1_idx]);
+
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
 
-    vm->acc().setValue(bit::castToWritable(ptr->getElem(pos)), false);
+    acc = bit::castToWritable(ptr->getElem<int32_t>(pos));
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrLdaF : {
-    auto instr = Instr<InstrOpcode::ARR_LDA_F>(vm->pc());
+    auto instr = Decoded<InstrOpcode::ARR_LDA_F>(pc);
 
-    auto &frame = vm->currFrame();
+    auto rs1_idx = instr.getRs1();
+    auto rs2_idx = instr.getRs2();
+
+    auto pos = static_cast<uint32_t>(regs[rs2_idx]);
+
+    auto ptr = std::bit_cast<Array *>(regs[rs1_idx]);
+
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
+
+    acc = bit::castToWritable(ptr->getElem<float>(pos));
+
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    ++pc;
+    goto *pc->handler;
+}
+handleArrLdaI32Nc : {
+    auto instr = Decoded<InstrOpcode::ARR_LDA_I32_NC>(pc);
 
     auto rs1_idx = instr.getRs1();
     auto rs2_idx = instr.getRs2();
 
-    auto pos = frame.getReg(rs2_idx).getValue();
+    auto pos = static_cast<uint32_t>(regs[rs2_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rs1_idx]);
+    assert(pos < ptr->getSize());
+
+    acc = bit::castToWritable(ptr->getElem<int32_t>(pos));
 
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rs1_idx).getValue());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->acc().setValue(bit::castToWritable(ptr->getElem(pos)), false);
+    ++pc;
+    goto *pc->handler;
+}
+handleArrLdaFNc : {
+    auto instr = Decoded<InstrOpcode::ARR_LDA_F_NC>(pc);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    auto rs1_idx = instr.getRs1();
+    auto rs2_idx = instr.getRs2();
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    auto pos = static_cast<uint32_t>(regs[rs2_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rs1_idx]);
+    assert(pos < ptr->getSize());
+
+    acc = bit::castToWritable(ptr->getElem<float>(pos));
+
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    ++pc;
+    goto *pc->handler;
 }
 handleArrLdaRef : {
-    auto instr = Instr<InstrOpcode::ARR_LDA_REF>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ARR_LDA_REF>(pc);
 
     auto rs1_idx = instr.getRs1();
     auto rs2_idx = instr.getRs2();
 
-    auto pos = frame.getReg(rs2_idx).getValue();
+    auto pos = static_cast<uint32_t>(regs[rs2_idx]);
 
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rs1_idx).getValue());
+    auto ptr = std::bit_cast<Array *>(regs[rs1_idx]);
+
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
 
     auto runtimeClassFromArr = reinterpret_cast<RuntimeArray *>(ptr->getClassWord());
     if (runtimeClassFromArr != nullptr) {
-        LOG_INFO("Name of class from array : " + runtimeClassFromArr->klass->name, vm->getLogLevel());
+        LOG_INFO("Name of class from array : " + runtimeClassFromArr->klass->name, LOG_LEVEL);
     } else {
+        saveState();
         return -1;
     }
 
-    vm->acc().setValue(bit::castToWritable(ptr->getElem(pos)), true);
+    acc = ptr->getElem<uint64_t>(pos);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleArrStaI32 : {
-    auto instr = Instr<InstrOpcode::ARR_STA_I32>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ARR_STA_I32>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto acc_val = vm->acc().getValue();
+    auto acc_val = acc;
 
-    auto pos = frame.getReg(rs_idx).getValue();
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rd_idx).getValue());
+    auto pos = static_cast<uint32_t>(regs[rs_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rd_idx]);
 
-    ptr->setElem(acc_val, pos);
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    ptr->setElem(bit::getValue<int32_t>(acc_val), pos);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    ++pc;
+    goto *pc->handler;
 }
 handleArrStaF : {
-    auto instr = Instr<InstrOpcode::ARR_STA_F>(vm->pc());
+    auto instr = Decoded<InstrOpcode::ARR_STA_F>(pc);
 
-    auto &frame = vm->currFrame();
+    auto rd_idx = instr.getRd();
+    auto rs_idx = instr.getRs();
+
+    auto acc_val = acc;
+
+    auto pos = static_cast<uint32_t>(regs[rs_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rd_idx]);
+
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
+
+    ptr->setElem(bit::getValue<float>(acc_val), pos);
+
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    ++pc;
+    goto *pc->handler;
+}
+handleArrStaI32Nc : {
+    auto instr = Decoded<InstrOpcode::ARR_STA_I32_NC>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto acc_val = vm->acc().getValue();
+    auto pos = static_cast<uint32_t>(regs[rs_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rd_idx]);
+    assert(pos < ptr->getSize());
 
-    auto pos = frame.getReg(rs_idx).getValue();
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rd_idx).getValue());
+    ptr->setElem(bit::getValue<int32_t>(acc), pos);
 
-    ptr->setElem(acc_val, pos);
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    ++pc;
+    goto *pc->handler;
+}
+handleArrStaFNc : {
+    auto instr = Decoded<InstrOpcode::ARR_STA_F_NC>(pc);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    auto rd_idx = instr.getRd();
+    auto rs_idx = instr.getRs();
+
+    auto pos = static_cast<uint32_t>(regs[rs_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rd_idx]);
+    assert(pos < ptr->getSize());
+
+    ptr->setElem(bit::getValue<float>(acc), pos);
+
+    LOG_INFO(instr.toString(), LOG_LEVEL);
+
+    ++pc;
+    goto *pc->handler;
 }
 handleArrStaRef : {
-    auto instr = Instr<InstrOpcode::ARR_STA_REF>(vm->pc());
-
-    auto &frame = vm->currFrame();
+    auto instr = Decoded<InstrOpcode::ARR_STA_REF>(pc);
 
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
-    auto acc_val = vm->acc().getValue();
+    auto acc_val = acc;
+
+    auto pos = static_cast<uint32_t>(regs[rs_idx]);
+    auto ptr = std::bit_cast<Array *>(regs[rd_idx]);
 
-    auto pos = frame.getReg(rs_idx).getValue();
-    auto ptr = std::bit_cast<Array *>(frame.getReg(rd_idx).getValue());
+    if (pos >= ptr->getSize()) [[unlikely]] {
+        saveState();
+        return reportOutOfBounds(vm, pc, pos, ptr->getSize());
+    }
 
     auto accAsClass = reinterpret_cast<Class *>(acc_val);
 
-    auto runtimeClassFromArr = reinterpret_cast<RuntimeClass *>(ptr->getClassWord());
+    auto runtimeClassFromArr = reinterpret_cast<RuntimeArray *>(ptr->getClassWord());
     auto runtimeClassFromAcc = reinterpret_cast<RuntimeClass *>(accAsClass->getClassWord());
     if (runtimeClassFromArr != nullptr && runtimeClassFromAcc != nullptr) {
-        if (runtimeClassFromArr->name != runtimeClassFromAcc->name) {
-            LOG_INFO("Name of class from array : " + runtimeClassFromArr->name, vm->getLogLevel());
-            LOG_INFO("Name of class from accumulator : " + runtimeClassFromAcc->name, vm->getLogLevel());
+        if (runtimeClassFromArr->klass != runtimeClassFromAcc) {
+            LOG_INFO("Name of class from array : " + runtimeClassFromArr->klass->name, LOG_LEVEL);
+            LOG_INFO("Name of class from accumulator : " + runtimeClassFromAcc->name, LOG_LEVEL);
         }
     } else {
+        saveState();
         return -1;
     }
 
-    LOG_INFO("pos to save : " << pos, vm->getLogLevel());
+    LOG_INFO("pos to save : " << pos, LOG_LEVEL);
 
+    vm->getAllocator().writeBarrier(ptr, *ptr->getElemAddr(pos));
     ptr->setElem(acc_val, pos);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleCmpLlI32 : {
-    Instr<InstrOpcode::CMP_LL_I32> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::CMP_LL_I32> instr {pc};
     auto rs_idx = instr.getRs();
 
-    auto ll = bit::getValue<int32_t>(vm->acc().getValue()) < bit::getValue<int32_t>(frame.getReg(rs_idx).getValue());
+    auto ll = bit::getValue<int32_t>(acc) < bit::getValue<int32_t>(regs[rs_idx]);
 
-    vm->acc().setValue(bit::castToWritable(static_cast<uint32_t>(ll)), false);
+    acc = bit::castToWritable(static_cast<uint32_t>(ll));
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleObjNew : {
-    vm->triggerGCIfNeed();
-    Instr<InstrOpcode::OBJ_NEW> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    triggerGCIfNeed();
+    Decoded<InstrOpcode::OBJ_NEW> instr {pc};
     auto rd_idx = instr.getRd();
 
     auto class_id = instr.getClassId();
@@ -966,56 +1232,62 @@ handleObjNew : {
     auto class_obj = Class::AllocateClassRef(reinterpret_cast<uint64_t>(&klass), klass.size, vm);
     auto ptr = reinterpret_cast<int32_t *>(class_obj);
 
-    frame.setReg(bit::castToWritable(ptr), rd_idx, true);
+    regs[rd_idx] = bit::castToWritable(ptr);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleLdfield : {
-    Instr<InstrOpcode::LDFIELD> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::LDFIELD> instr {pc};
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
     const auto &field = vm->resolveField(instr.getClassId(), instr.getFieldId());
 
     const auto &classIdFromInstr = vm->getClasses()[instr.getClassId()];
-    LOG_INFO("Name of class from instr : " << classIdFromInstr.name, vm->getLogLevel());
+    LOG_INFO("Name of class from instr : " << classIdFromInstr.name, LOG_LEVEL);
 
-    auto class_ptr = std::bit_cast<Class *>(frame.getReg(rs_idx).getValue());
-    LOG_INFO("Class ptr from reg : " << class_ptr, vm->getLogLevel());
+    auto class_ptr = std::bit_cast<Class *>(regs[rs_idx]);
+    LOG_INFO("Class ptr from reg : " << class_ptr, LOG_LEVEL);
 
     LOG_INFO("Name of class from ptr : " << reinterpret_cast<RuntimeClass *>(class_ptr->getClassWord())->name,
-             vm->getLogLevel());
+             LOG_LEVEL);
 
     uint64_t ld_tmp = class_ptr->getField(field);
 
-    frame.setReg(ld_tmp, rd_idx, field.is_ref);
+    regs[rd_idx] = ld_tmp;
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 handleStfield : {
-    Instr<InstrOpcode::STFIELD> instr {vm->pc()};
-    auto &frame = vm->currFrame();
+    Decoded<InstrOpcode::STFIELD> instr {pc};
     auto rd_idx = instr.getRd();
     auto rs_idx = instr.getRs();
 
     const auto &field = vm->resolveField(instr.getClassId(), instr.getFieldId());
-    uint64_t field_val = frame.getReg(rs_idx).getValue();
+    uint64_t field_val = regs[rs_idx];
 
-    auto class_ptr = std::bit_cast<Class *>(frame.getReg(rd_idx).getValue());
+    auto class_ptr = std::bit_cast<Class *>(regs[rd_idx]);
 
+    if (field.is_ref) {
+        vm->getAllocator().writeBarrier(class_ptr, *class_ptr->getRefFieldAddr(field));
+    }
     class_ptr->setField(field, field_val);
 
-    LOG_INFO(instr.toString(), vm->getLogLevel());
+    LOG_INFO(instr.toString(), LOG_LEVEL);
 
-    vm->pc() += instr.getByteSize();
-    goto *dispatch_table[getOpcode(vm->pc())];
+    ++pc;
+    goto *pc->handler;
 }
 }
 
+template int runImpl<LogLevel::NONE>(ShrimpVM *vm);
+template int runImpl<LogLevel::ERROR>(ShrimpVM *vm);
+template int runImpl<LogLevel::INFO>(ShrimpVM *vm);
+template int runImpl<LogLevel::DEBUG>(ShrimpVM *vm);
+
 }  // namespace shrimp::runtime::interpreter
\ No newline at end of file
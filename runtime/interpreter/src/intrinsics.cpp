@@ -1,23 +1,374 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include <shrimp/runtime/interpreter/intrinsics.hpp>
 
 namespace shrimp::runtime::intrinsics {
 
-void PrintI(int val)
+namespace {
+
+// Kernels over array elements, one set per instruction set
+struct ArrayKernels {
+    void (*fill)(uint32_t *data, size_t size, uint32_t val);
+    int32_t (*sum_i)(const int32_t *data, size_t size);
+    float (*sum_f)(const float *data, size_t size);
+    float (*dot_f)(const float *x, const float *y, size_t size);
+    void (*axpy_f)(float a, const float *x, float *y, size_t size);
+    // Min and max kernels expect non-empty array
+    int32_t (*min_i)(const int32_t *data, size_t size);
+    int32_t (*max_i)(const int32_t *data, size_t size);
+    float (*min_f)(const float *data, size_t size);
+    float (*max_f)(const float *data, size_t size);
+};
+
+namespace scalar {
+
+// Wraps around on overflow like ADD.I32
+int32_t Add(int32_t lhs, int32_t rhs)
+{
+    return static_cast<int32_t>(static_cast<uint32_t>(lhs) + static_cast<uint32_t>(rhs));
+}
+
+float Add(float lhs, float rhs)
+{
+    return lhs + rhs;
+}
+
+template <bool IS_MAX, typename T>
+T Pick(T lhs, T rhs)
+{
+    if constexpr (IS_MAX) {
+        return std::max(lhs, rhs);
+    } else {
+        return std::min(lhs, rhs);
+    }
+}
+
+// Vector kernels finish tails of arrays and fold lanes with scalar loops, starting from acc
+template <typename T>
+T Sum(T acc, const T *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        acc = Add(acc, data[i]);
+    }
+    return acc;
+}
+
+template <bool IS_MAX, typename T>
+T Extremum(T acc, const T *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        acc = Pick<IS_MAX>(acc, data[i]);
+    }
+    return acc;
+}
+
+float Dot(float acc, const float *x, const float *y, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        acc += x[i] * y[i];
+    }
+    return acc;
+}
+
+void Axpy(float a, const float *x, float *y, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        y[i] += a * x[i];
+    }
+}
+
+void Fill(uint32_t *data, size_t size, uint32_t val)
+{
+    std::fill_n(data, size, val);
+}
+
+[[maybe_unused]] constexpr ArrayKernels KERNELS {
+    Fill,
+    [](const int32_t *data, size_t size) { return Sum(0, data, size); },
+    [](const float *data, size_t size) { return Sum(0.0F, data, size); },
+    [](const float *x, const float *y, size_t size) { return Dot(0.0F, x, y, size); },
+    Axpy,
+    [](const int32_t *data, size_t size) { return Extremum<false>(data[0], data + 1, size - 1); },
+    [](const int32_t *data, size_t size) { return Extremum<true>(data[0], data + 1, size - 1); },
+    [](const float *data, size_t size) { return Extremum<false>(data[0], data + 1, size - 1); },
+    [](const float *data, size_t size) { return Extremum<true>(data[0], data + 1, size - 1); },
+};
+
+}  // namespace scalar
+
+#if defined(__x86_64__)
+
+// SSE2 is part of x86-64, so these kernels run on any CPU of it
+namespace sse2 {
+
+constexpr size_t LANES = 4;
+
+template <bool IS_MAX>
+__m128i PickI(__m128i lhs, __m128i rhs)
+{
+    __m128i greater = _mm_cmpgt_epi32(lhs, rhs);
+    if constexpr (IS_MAX) {
+        return _mm_or_si128(_mm_and_si128(greater, lhs), _mm_andnot_si128(greater, rhs));
+    } else {
+        return _mm_or_si128(_mm_and_si128(greater, rhs), _mm_andnot_si128(greater, lhs));
+    }
+}
+
+void Fill(uint32_t *data, size_t size, uint32_t val)
+{
+    __m128i vec = _mm_set1_epi32(static_cast<int32_t>(val));
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), vec);
+    }
+    scalar::Fill(data + i, size - i, val);
+}
+
+int32_t SumI(const int32_t *data, size_t size)
+{
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+    }
+    alignas(16) int32_t lanes[LANES];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    return scalar::Sum(scalar::Sum(0, lanes, LANES), data + i, size - i);
+}
+
+float SumF(const float *data, size_t size)
+{
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(data + i));
+    }
+    alignas(16) float lanes[LANES];
+    _mm_store_ps(lanes, acc);
+    return scalar::Sum(scalar::Sum(0.0F, lanes, LANES), data + i, size - i);
+}
+
+float DotF(const float *x, const float *y, size_t size)
+{
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+    }
+    alignas(16) float lanes[LANES];
+    _mm_store_ps(lanes, acc);
+    return scalar::Dot(scalar::Sum(0.0F, lanes, LANES), x + i, y + i, size - i);
+}
+
+void AxpyF(float a, const float *x, float *y, size_t size)
+{
+    __m128 vec_a = _mm_set1_ps(a);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(vec_a, _mm_loadu_ps(x + i))));
+    }
+    scalar::Axpy(a, x + i, y + i, size - i);
+}
+
+template <bool IS_MAX>
+int32_t ExtremumI(const int32_t *data, size_t size)
+{
+    __m128i acc = _mm_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = PickI<IS_MAX>(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i)));
+    }
+    alignas(16) int32_t lanes[LANES];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    return scalar::Extremum<IS_MAX>(scalar::Extremum<IS_MAX>(data[0], lanes, LANES), data + i, size - i);
+}
+
+template <bool IS_MAX>
+float ExtremumF(const float *data, size_t size)
+{
+    __m128 acc = _mm_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        __m128 vec = _mm_loadu_ps(data + i);
+        acc = IS_MAX ? _mm_max_ps(acc, vec) : _mm_min_ps(acc, vec);
+    }
+    alignas(16) float lanes[LANES];
+    _mm_store_ps(lanes, acc);
+    return scalar::Extremum<IS_MAX>(scalar::Extremum<IS_MAX>(data[0], lanes, LANES), data + i, size - i);
+}
+
+constexpr ArrayKernels KERNELS {
+    Fill, SumI, SumF, DotF, AxpyF, ExtremumI<false>, ExtremumI<true>, ExtremumF<false>, ExtremumF<true>,
+};
+
+}  // namespace sse2
+
+namespace avx2 {
+
+constexpr size_t LANES = 8;
+
+__attribute__((target("avx2"))) void Fill(uint32_t *data, size_t size, uint32_t val)
+{
+    __m256i vec = _mm256_set1_epi32(static_cast<int32_t>(val));
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i), vec);
+    }
+    scalar::Fill(data + i, size - i, val);
+}
+
+__attribute__((target("avx2"))) int32_t SumI(const int32_t *data, size_t size)
+{
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i)));
+    }
+    alignas(32) int32_t lanes[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    return scalar::Sum(scalar::Sum(0, lanes, LANES), data + i, size - i);
+}
+
+__attribute__((target("avx2"))) float SumF(const float *data, size_t size)
+{
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    alignas(32) float lanes[LANES];
+    _mm256_store_ps(lanes, acc);
+    return scalar::Sum(scalar::Sum(0.0F, lanes, LANES), data + i, size - i);
+}
+
+__attribute__((target("avx2"))) float DotF(const float *x, const float *y, size_t size)
+{
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    alignas(32) float lanes[LANES];
+    _mm256_store_ps(lanes, acc);
+    return scalar::Dot(scalar::Sum(0.0F, lanes, LANES), x + i, y + i, size - i);
+}
+
+__attribute__((target("avx2"))) void AxpyF(float a, const float *x, float *y, size_t size)
+{
+    __m256 vec_a = _mm256_set1_ps(a);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(vec_a, _mm256_loadu_ps(x + i))));
+    }
+    scalar::Axpy(a, x + i, y + i, size - i);
+}
+
+template <bool IS_MAX>
+__attribute__((target("avx2"))) int32_t ExtremumI(const int32_t *data, size_t size)
+{
+    __m256i acc = _mm256_set1_epi32(data[0]);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        acc = IS_MAX ? _mm256_max_epi32(acc, vec) : _mm256_min_epi32(acc, vec);
+    }
+    alignas(32) int32_t lanes[LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+    return scalar::Extremum<IS_MAX>(scalar::Extremum<IS_MAX>(data[0], lanes, LANES), data + i, size - i);
+}
+
+template <bool IS_MAX>
+__attribute__((target("avx2"))) float ExtremumF(const float *data, size_t size)
 {
-    std::cout << val << std::endl;
+    __m256 acc = _mm256_set1_ps(data[0]);
+    size_t i = 0;
+    for (; i + LANES <= size; i += LANES) {
+        __m256 vec = _mm256_loadu_ps(data + i);
+        acc = IS_MAX ? _mm256_max_ps(acc, vec) : _mm256_min_ps(acc, vec);
+    }
+    alignas(32) float lanes[LANES];
+    _mm256_store_ps(lanes, acc);
+    return scalar::Extremum<IS_MAX>(scalar::Extremum<IS_MAX>(data[0], lanes, LANES), data + i, size - i);
 }
 
-void PrintF(float val)
+constexpr ArrayKernels KERNELS {
+    Fill, SumI, SumF, DotF, AxpyF, ExtremumI<false>, ExtremumI<true>, ExtremumF<false>, ExtremumF<true>,
+};
+
+}  // namespace avx2
+
+#endif  // defined(__x86_64__)
+
+ArrayKernels SelectKernels()
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2::KERNELS;
+    }
+    return sse2::KERNELS;
+#else
+    return scalar::KERNELS;
+#endif
+}
+
+// Chosen once at startup by features of CPU
+const ArrayKernels KERNELS = SelectKernels();
+
+}  // namespace
+
+void OutputBuffer::write(std::string_view str)
 {
-    std::cout << val << std::endl;
+    if (CAPACITY - size_ < str.size()) {
+        flush();
+        // Strings longer than buffer are written as is
+        if (str.size() > CAPACITY) {
+            std::cout.write(str.data(), str.size()).flush();
+            return;
+        }
+    }
+    std::memcpy(data_.get() + size_, str.data(), str.size());
+    size_ += str.size();
 }
 
-void PrintStr(const std::string &str)
+void OutputBuffer::flush()
 {
-    std::cout << str << std::endl;
+    if (size_ == 0) {
+        return;
+    }
+    std::cout.write(data_.get(), size_).flush();
+    size_ = 0;
+}
+
+void PrintI(OutputBuffer &out, int val)
+{
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof(buf) - 1, val);
+    *res.ptr++ = '\n';
+    out.write({buf, res.ptr});
+}
+
+// Six significant digits as std::cout prints floats by default
+void PrintF(OutputBuffer &out, float val)
+{
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf) - 1, val, std::chars_format::general, 6);
+    *res.ptr++ = '\n';
+    out.write({buf, res.ptr});
+}
+
+void PrintStr(OutputBuffer &out, std::string_view str)
+{
+    out.write(str);
+    out.write("\n");
 }
 
 std::string Concat(const std::string &str1, const std::string &str2)
@@ -30,15 +381,17 @@ std::string Substr(const std::string &str, size_t pos, size_t len)
     return str.substr(pos, len);
 }
 
-int ScanI()
+int ScanI(OutputBuffer &out)
 {
+    out.flush();
     int val;
     std::cin >> val;
     return val;
 }
 
-float ScanF()
+float ScanF(OutputBuffer &out)
 {
+    out.flush();
     float val;
     std::cin >> val;
     return val;
@@ -59,4 +412,55 @@ float SqrtF(float val)
     return std::sqrt(val);
 }
 
+void ArrFill(uint32_t *data, size_t size, uint32_t val)
+{
+    KERNELS.fill(data, size, val);
+}
+
+// memmove of libc is already vectorized for CPU it runs on
+void ArrCopy(uint32_t *dst, const uint32_t *src, size_t size)
+{
+    std::memmove(dst, src, size * sizeof(uint32_t));
+}
+
+int32_t ArrSumI(const int32_t *data, size_t size)
+{
+    return KERNELS.sum_i(data, size);
+}
+
+float ArrSumF(const float *data, size_t size)
+{
+    return KERNELS.sum_f(data, size);
+}
+
+float ArrDotF(const float *x, const float *y, size_t size)
+{
+    return KERNELS.dot_f(x, y, size);
+}
+
+void ArrAxpyF(float a, const float *x, float *y, size_t size)
+{
+    KERNELS.axpy_f(a, x, y, size);
+}
+
+int32_t ArrMinI(const int32_t *data, size_t size)
+{
+    return size == 0 ? 0 : KERNELS.min_i(data, size);
+}
+
+int32_t ArrMaxI(const int32_t *data, size_t size)
+{
+    return size == 0 ? 0 : KERNELS.max_i(data, size);
+}
+
+float ArrMinF(const float *data, size_t size)
+{
+    return size == 0 ? 0.0F : KERNELS.min_f(data, size);
+}
+
+float ArrMaxF(const float *data, size_t size)
+{
+    return size == 0 ? 0.0F : KERNELS.max_f(data, size);
+}
+
 }  // namespace shrimp::runtime::intrinsics
@@ -0,0 +1,62 @@
+#ifndef RUNTIME_MEMORY_CARD_TABLE_HPP
+#define RUNTIME_MEMORY_CARD_TABLE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <shrimp/runtime/memory/memory_resource.hpp>
+
+namespace shrimp::runtime {
+
+// One byte per CARD_SIZE bytes of covered memory. Write barrier dirties card of object
+// a reference is stored to, so minor GC finds old-to-young references without scanning old space
+class CardTable final {
+public:
+    static constexpr size_t CARD_SHIFT = 9;
+    static constexpr size_t CARD_SIZE = size_t {1} << CARD_SHIFT;
+
+    CardTable(uint8_t *begin, size_t size) : begin_(begin), cards_((size + CARD_SIZE - 1) >> CARD_SHIFT) {}
+
+    void markCard(const void *addr) noexcept
+    {
+        cards_[(static_cast<const uint8_t *>(addr) - begin_) >> CARD_SHIFT] = DIRTY;
+    }
+
+    // Visit memory ranges of dirty cards below end and clean them
+    template <typename Visitor>
+    void forEachDirtyCard(const uint8_t *end, Visitor visitor)
+    {
+        constexpr size_t WORD_SIZE = sizeof(uint64_t);
+        size_t num_of_cards = std::min(cards_.size(), ((end - begin_) + CARD_SIZE - 1) >> CARD_SHIFT);
+        for (size_t idx = 0; idx < num_of_cards; idx++) {
+            // Skip clean words at once, dirty cards are rare
+            if (idx % WORD_SIZE == 0 && idx + WORD_SIZE <= num_of_cards) {
+                uint64_t word = 0;
+                std::memcpy(&word, cards_.data() + idx, WORD_SIZE);
+                if (word == 0) {
+                    idx += WORD_SIZE - 1;
+                    continue;
+                }
+            }
+            if (cards_[idx] == CLEAN) {
+                continue;
+            }
+            cards_[idx] = CLEAN;
+            uint8_t *card_begin = begin_ + (idx << CARD_SHIFT);
+            visitor(card_begin, card_begin + CARD_SIZE);
+        }
+    }
+
+private:
+    static constexpr uint8_t CLEAN = 0;
+    static constexpr uint8_t DIRTY = 1;
+
+    uint8_t *begin_ = nullptr;
+    // Zeroed memory is clean
+    ReservedArray<uint8_t> cards_;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // RUNTIME_MEMORY_CARD_TABLE_HPP
@@ -1,165 +1,525 @@
 #ifndef RUNTIME_MEMORY_GC_HPP
 #define RUNTIME_MEMORY_GC_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
 #include "shrimp/common/logger.hpp"
 #include "shrimp/common/types.hpp"
 #include "shrimp/runtime/coretypes/array.hpp"
 #include "shrimp/runtime/coretypes/class.hpp"
+#include "shrimp/runtime/coretypes/string.hpp"
 #include "shrimp/runtime/memory/class_word.hpp"
-#include "shrimp/runtime/memory/mark_word.hpp"
+#include "shrimp/runtime/memory/gc_options.hpp"
+#include "shrimp/runtime/memory/gc_workers.hpp"
+#include "shrimp/runtime/memory/generational_heap.hpp"
 #include "shrimp/runtime/memory/memory_resource.hpp"
 #include "shrimp/runtime/memory/object_header.hpp"
+#include "shrimp/runtime/memory/work_stealing_stack.hpp"
 #include "shrimp/runtime/shrimp_vm.hpp"
+#include "shrimp/runtime/stack_map.hpp"
 
 namespace shrimp::runtime::mem {
 
 class GC {
 public:
-    GC(ShrimpVM *vm) : vm_(vm)
+    GC(ShrimpVM *vm, const GCOptions &options) : vm_(vm), heap_(vm->getAllocator()), max_pause_(options.max_pause)
     {
-        stringClassWord_ = reinterpret_cast<ClassWord>(&vm_->getStringClass());
+        stringClassWord_ = reinterpret_cast<ClassWord>(&vm_->getStringClass(StringKind::FLAT));
+        if (options.num_of_threads > 1) {
+            workers_ = std::make_unique<GCWorkers>(options.num_of_threads);
+            for (size_t i = 0; i < options.num_of_threads; i++) {
+                mark_workers_.emplace_back();
+            }
+        }
     }
+    // Minor GC empties nursery, old space is collected by mark-sweep when it is full and by mark-compact
+    // when its chunks exceed its limit, which follows live size. With max pause set old space is swept
+    // and marked in steps requested by allocations, each bounded by max pause unless old space gets full
+    // before marking is finished
     void run()
     {
-        LOG_DEBUG("[BEFORE GC] Allocations: " << vm_->getAllocator().getAllocations().size(), vm_->getLogLevel());
-        LOG_DEBUG("[BEFORE GC] Allocated : " << vm_->getAllocator().getAllocated(), vm_->getLogLevel());
+        auto deadline = Clock::now() + max_pause_;
+        LOG_DEBUG("[BEFORE GC] Objects: " << heap_.getNumOfObjects(), vm_->getLogLevel());
+        LOG_DEBUG("[BEFORE GC] Allocated : " << heap_.getAllocated(), vm_->getLogLevel());
+        if (heap_.isNurseryFull() || heap_.isOldSpaceFull()) {
+            collectYoung();
+        }
+        bool is_incremental = max_pause_.count() != 0;
+        bool must_finish = !is_incremental || heap_.isOldSpaceFull();
+        if (must_finish) {
+            deadline = Clock::time_point::max();
+        }
+        if (!heap_.isMarking()) {
+            bool need_marking = must_finish ? heap_.isOldSpaceFull() : heap_.isOldSpaceFilling();
+            // Incremental steps sweep chunks out of allocation path. Objects left from previous cycle
+            // must be swept before marking, so they are not seen as roots or marked
+            auto &old_space = heap_.getOldSpace();
+            if (is_incremental || need_marking) {
+                while (old_space.sweepNextChunk() && Clock::now() < deadline) {
+                }
+            }
+            if (need_marking && old_space.isSwept()) {
+                startMarking();
+            }
+        }
+        if (heap_.isMarking()) {
+            LOG_DEBUG("Start of marking slice", vm_->getLogLevel());
+            bool is_done = mark(deadline);
+            LOG_DEBUG("End of marking slice", vm_->getLogLevel());
+            if (is_done) {
+                heap_.resizeOldSpace(live_bytes_);
+                pruneInternTable();
+                LOG_DEBUG("Old space limit : " << heap_.getOldSpaceLimit(), vm_->getLogLevel());
+            }
+            if (is_done && heap_.isOldSpaceExhausted()) {
+                compact();
+            } else if (is_done) {
+                finishMarking();
+            }
+        }
+        if (is_incremental) {
+            heap_.requestStepAfter(INCREMENTAL_STEP_SIZE);
+        }
+        LOG_DEBUG("[AFTER GC] Allocated : " << heap_.getAllocated(), vm_->getLogLevel());
+        LOG_DEBUG("[AFTER GC] Objects: " << heap_.getNumOfObjects(), vm_->getLogLevel());
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Objects scanned between deadline checks, also least work of marking slice
+    static constexpr size_t DEADLINE_CHECK_PERIOD = 256;
+    // Allocated bytes between incremental steps
+    static constexpr size_t INCREMENTAL_STEP_SIZE = 0x40000;
+
+    // State of GC thread marking in parallel
+    struct MarkWorker {
+        WorkStealingStack stack;
+        size_t live_bytes = 0;
+        size_t live_objects = 0;
+    };
+
+    // Ring buffer of objects whose headers are being prefetched
+    class PrefetchQueue final {
+    public:
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+        bool full() const noexcept
+        {
+            return size_ == DEPTH;
+        }
+        void push(ObjectHeader *obj) noexcept
+        {
+            objs_[(head_ + size_++) % DEPTH] = obj;
+        }
+        ObjectHeader *pop() noexcept
+        {
+            auto *obj = objs_[head_];
+            head_ = (head_ + 1) % DEPTH;
+            size_--;
+            return obj;
+        }
+
+    private:
+        static constexpr size_t DEPTH = 8;
+
+        std::array<ObjectHeader *, DEPTH> objs_ {};
+        size_t head_ = 0;
+        size_t size_ = 0;
+    };
+
+    // Copy live nursery objects to old space. Roots are registers, interned strings and old objects
+    // of dirty cards, promoted copies are scanned in allocation order as in Cheney's algorithm
+    void collectYoung()
+    {
+        LOG_DEBUG("Start of minor GC", vm_->getLogLevel());
+        promoted_.clear();
+        auto evacuate = [this](uint64_t &slot) { slot = evacuateIfYoung(slot); };
+        forEachRootSlot([&](uint64_t &slot, bool /*is_ambiguous*/) { evacuate(slot); });
+        heap_.getCardTable().forEachDirtyCard(heap_.getArenaTop(), [&](uint8_t *begin, uint8_t *end) {
+            if (heap_.getNursery().contains(begin)) {
+                return;
+            }
+            heap_.getOldSpace().forEachObjectIn(begin, end, [&](ObjectHeader *obj) { forEachRefSlot(obj, evacuate); });
+        });
+        for (size_t i = 0; i < promoted_.size(); i++) {
+            forEachRefSlot(promoted_[i], evacuate);
+        }
+        // Interned strings are weak, young ones not promoted by now are dead
+        vm_->getInternTable().updateYoung([this](uint64_t ref) -> uint64_t {
+            auto *obj = reinterpret_cast<ObjectHeader *>(ref);
+            return obj->isForwarded() ? reinterpret_cast<uint64_t>(heap_.decompressAddr(obj->getForwardingAddr())) : 0;
+        });
+        LOG_DEBUG("Promoted objects : " << promoted_.size(), vm_->getLogLevel());
+        heap_.getNursery().reset();
+        LOG_DEBUG("End of minor GC", vm_->getLogLevel());
+    }
+
+    // Return address of old space copy for nursery reference, other values are unchanged
+    uint64_t evacuateIfYoung(uint64_t ref)
+    {
+        if (!heap_.isYoung(ref)) {
+            return ref;
+        }
+        auto *obj = reinterpret_cast<ObjectHeader *>(ref);
+        if (obj->isForwarded()) {
+            return reinterpret_cast<uint64_t>(heap_.decompressAddr(obj->getForwardingAddr()));
+        }
+        size_t size = obj->getObjectSize();
+        auto *copy = static_cast<ObjectHeader *>(heap_.getOldSpace().allocate(size));
+        if (copy == nullptr) {
+            std::cerr << "Out of memory while promoting objects" << std::endl;
+            std::abort();
+        }
+        std::memcpy(copy, obj, size);
+        obj->setForwardingAddr(heap_.compressAddr(copy));
+        promoted_.push_back(copy);
+        return reinterpret_cast<uint64_t>(copy);
+    }
+
+    // Marking starts from snapshot of roots taken with empty nursery. Objects unlinked later
+    // are shaded by write barrier and objects allocated later are black
+    void startMarking()
+    {
+        LOG_DEBUG("Start of major GC", vm_->getLogLevel());
+        if (heap_.getNursery().getUsed() != 0) {
+            collectYoung();
+        }
+        live_bytes_ = 0;
+        live_objects_ = 0;
         collectRoots();
-        LOG_DEBUG("Start of marking", vm_->getLogLevel());
-        mark(MarkWord::GCState::MARKED);
-        LOG_DEBUG("End of marking", vm_->getLogLevel());
+        for (auto *root : roots_) {
+            LOG_DEBUG("ObjectHeader " << root, vm_->getLogLevel());
+            pushGray(reinterpret_cast<uint64_t>(root));
+        }
+        heap_.startMarking();
+    }
+
+    void finishMarking()
+    {
+        heap_.finishMarking();
         sweep();
-        LOG_DEBUG("Start of post-marking", vm_->getLogLevel());
-        mark(MarkWord::GCState::UNMARKED);
-        LOG_DEBUG("End of post-marking", vm_->getLogLevel());
-        LOG_DEBUG("[AFTER GC] Allocated : " << vm_->getAllocator().getAllocated(), vm_->getLogLevel());
-        LOG_DEBUG("[AFTER GC] Allocations: " << vm_->getAllocator().getAllocations().size(), vm_->getLogLevel());
+        LOG_DEBUG("End of major GC", vm_->getLogLevel());
+    }
+
+    // Lisp2 sliding compaction is done instead of sweep: marked objects get forwarding addresses,
+    // references of roots and marked objects are updated, then objects are slid down. Objects
+    // referenced from ambiguous registers are pinned, since the registers may hold plain values
+    void compact()
+    {
+        LOG_DEBUG("Start of compaction", vm_->getLogLevel());
+        if (heap_.getNursery().getUsed() != 0) {
+            collectYoung();
+        }
+        heap_.finishMarking();
+        auto &old_space = heap_.getOldSpace();
+        pinned_.clear();
+        forEachRootSlot([&](uint64_t &slot, bool is_ambiguous) {
+            if (is_ambiguous && old_space.isObjectStart(slot)) {
+                pinned_.push_back(reinterpret_cast<ObjectHeader *>(slot));
+            }
+        });
+        std::sort(pinned_.begin(), pinned_.end());
+        old_space.computeForwarding(
+            [this](ObjectHeader *obj) { return std::binary_search(pinned_.begin(), pinned_.end(), obj); });
+        auto forward = [this](uint64_t &slot) {
+            if (slot != 0) {
+                auto *obj = reinterpret_cast<ObjectHeader *>(slot);
+                slot = reinterpret_cast<uint64_t>(heap_.decompressAddr(obj->getForwardingAddr()));
+            }
+        };
+        forEachRootSlot([&](uint64_t &slot, bool is_ambiguous) {
+            if (!is_ambiguous) {
+                forward(slot);
+            }
+        });
+        old_space.forEachMarkedObject([&](ObjectHeader *obj) { forEachRefSlot(obj, forward); });
+        vm_->getInternTable().updateAll([&](uint64_t ref) {
+            forward(ref);
+            return ref;
+        });
+        old_space.compact();
+        LOG_DEBUG("Old space after compaction : " << old_space.getFootprint(), vm_->getLogLevel());
+        LOG_DEBUG("End of compaction", vm_->getLogLevel());
+    }
+
+    // Interned strings are weak, old ones left unmarked by finished marking are dead
+    void pruneInternTable()
+    {
+        auto &old_space = heap_.getOldSpace();
+        vm_->getInternTable().updateAll([&](uint64_t ref) -> uint64_t {
+            return heap_.isYoung(ref) || old_space.isMarked(reinterpret_cast<ObjectHeader *>(ref)) ? ref : 0;
+        });
+        LOG_DEBUG("Interned strings : " << vm_->getInternTable().size(), vm_->getLogLevel());
     }
 
-private:
     void collectRoots()
     {
         LOG_DEBUG("Start of collecting", vm_->getLogLevel());
-        for (auto &stack : vm_->stack()) {
-            for (size_t i = 0; i < 256; i++) {
-                const auto &reg = stack.getReg(i);
-                if (reg.getRefMark() == 1) {
-                    LOG_DEBUG("Register : " << i << "; Value : " << reg.getValue(), vm_->getLogLevel());
-                    roots_.push_back(reinterpret_cast<ObjectHeader *>(reg.getValue()));
-                }
+        roots_.clear();
+        forEachRootSlot([&](uint64_t &slot, bool is_ambiguous) {
+            if (is_ambiguous) {
+                addAmbiguousRoot(slot);
+            } else {
+                roots_.push_back(reinterpret_cast<ObjectHeader *>(slot));
             }
-        }
-        if (vm_->acc().getRefMark() == 1) {
-            LOG_DEBUG("Register : Acc; Value : " << vm_->acc().getValue(), vm_->getLogLevel());
-            roots_.push_back(reinterpret_cast<ObjectHeader *>(vm_->acc().getValue()));
-        }
+        });
         LOG_DEBUG("End of collecting", vm_->getLogLevel());
     }
 
-    void markClass(Class *klass, MarkWord::GCState state)
+    // Visit registers, accumulator and interned strings which may hold references, visitor gets slot
+    // and whether it is ambiguous
+    template <typename Visitor>
+    void forEachRootSlot(Visitor visitor)
     {
-        LOG_DEBUG("Class " << klass, vm_->getLogLevel());
-        if (klass->getGCState() == state) {
-            return;
+        // Walk frames from the top one, each is suspended at safepoint described by stack map:
+        // the top one at current pc, callers at their call instructions
+        auto &stack = vm_->stack();
+        const DecodedInstr *pc = vm_->pc();
+        for (auto *frame = stack.end(); frame != stack.begin();) {
+            --frame;
+            const auto *stack_map = vm_->findStackMap(pc);
+            if (stack_map == nullptr) {
+                std::cerr << "No stack map for safepoint" << std::endl;
+                std::abort();
+            }
+            auto regs = frame->getRegs();
+            stack_map->forEachRef([&](size_t i) {
+                LOG_DEBUG("Register : " << i << "; Value : " << regs[i], vm_->getLogLevel());
+                visitor(regs[i], false);
+            });
+            stack_map->forEachAmbiguous([&](size_t i) { visitor(regs[i], true); });
+            if (frame + 1 == stack.end() && stack_map->getAccKind() != StackMap::AccKind::VALUE) {
+                LOG_DEBUG("Register : Acc; Value : " << vm_->acc(), vm_->getLogLevel());
+                visitor(vm_->acc(), stack_map->getAccKind() == StackMap::AccKind::AMBIGUOUS);
+            }
+            if (frame != stack.begin()) {
+                pc = frame->getRetPc() - 1;
+            }
         }
-        auto classWord = klass->getClassWord();
-        auto runtimeClass = reinterpret_cast<RuntimeClass *>(classWord);
-
-        for (const auto &field : runtimeClass->fields) {
-            if (!field.is_ref) {
-                continue;
+        for (auto &slot : vm_->getInternedStrings()) {
+            if (slot != 0) {
+                visitor(slot, false);
             }
-            auto refField = reinterpret_cast<Class *>(klass->getField(field));
-            if (refField == 0) {
-                continue;
+        }
+        for (auto &slot : vm_->getCharStrings()) {
+            if (slot != 0) {
+                visitor(slot, false);
             }
-            markClass(refField, state);
         }
-        klass->setGCState(state);
     }
 
-    void markArray(Array *arr, MarkWord::GCState state)
+    // Value of ambiguous register is treated as root only if it is start of allocated object
+    void addAmbiguousRoot(uint64_t value)
     {
-        LOG_DEBUG("Array " << arr, vm_->getLogLevel());
-        if (arr->getGCState() == state) {
-            return;
+        if (heap_.getOldSpace().isObjectStart(value)) {
+            LOG_DEBUG("Ambiguous root : " << value, vm_->getLogLevel());
+            roots_.push_back(reinterpret_cast<ObjectHeader *>(value));
         }
-        auto classWord = arr->getClassWord();
-        arr->setGCState(state);
+    }
 
-        auto array = reinterpret_cast<RuntimeArray *>(classWord);
-        auto refClass = array->klass;
-        if (refClass == 0) {
-            return;
+    // Mark objects reachable from gray ones in old space mark bitmap using explicit mark stack until
+    // deadline, return true if no gray objects are left. Popped objects pass small FIFO queue,
+    // so their headers are prefetched before scanning
+    bool mark(Clock::time_point deadline)
+    {
+        auto &deleted_refs = heap_.getDeletedRefs();
+        for (auto *obj : deleted_refs) {
+            pushGray(reinterpret_cast<uint64_t>(obj));
         }
-        auto size = arr->getSize();
-        for (uint32_t i = 0; i < size; i++) {
-            auto elem = arr->getElem(i);
-            if (elem != 0) {
-                markClass(reinterpret_cast<Class *>(elem), state);
+        deleted_refs.clear();
+        if (workers_ != nullptr) {
+            return markParallel(deadline);
+        }
+        PrefetchQueue queue;
+        bool has_time = true;
+        for (size_t scanned = 1;; scanned++) {
+            while (has_time && !queue.full() && !mark_stack_.empty()) {
+                auto *obj = mark_stack_.back();
+                mark_stack_.pop_back();
+                __builtin_prefetch(obj, 1);
+                queue.push(obj);
+            }
+            if (queue.empty()) {
+                break;
+            }
+            auto *obj = queue.pop();
+            LOG_DEBUG("Mark " << obj, vm_->getLogLevel());
+            live_bytes_ += obj->getObjectSize();
+            live_objects_++;
+            forEachRefSlot(obj, [this](uint64_t &slot) { pushGray(slot); });
+            if (scanned % DEADLINE_CHECK_PERIOD == 0) {
+                has_time = Clock::now() < deadline;
             }
         }
+        return mark_stack_.empty();
     }
-    void mark(MarkWord::GCState state)
+
+    // Gray objects are spread over GC threads, which mark with atomic bitmap operations and steal
+    // published work of each other when idle. Leftovers of threads stopped by deadline are gathered back
+    bool markParallel(Clock::time_point deadline)
     {
-        for (auto &root : roots_) {
-            LOG_DEBUG("ObjectHeader " << root, vm_->getLogLevel());
-            if (root == 0) {
-                LOG_DEBUG("nullptr in root", vm_->getLogLevel());
-                continue;
+        size_t num_of_workers = mark_workers_.size();
+        for (size_t i = 0; i < mark_stack_.size(); i++) {
+            mark_workers_[i % num_of_workers].stack.push(mark_stack_[i]);
+        }
+        mark_stack_.clear();
+        num_of_idle_workers_.store(0);
+        is_mark_stopped_.store(false);
+        workers_->run([this, deadline](size_t idx) { markByWorker(mark_workers_[idx], idx, deadline); });
+        for (auto &worker : mark_workers_) {
+            live_bytes_ += std::exchange(worker.live_bytes, 0);
+            live_objects_ += std::exchange(worker.live_objects, 0);
+            worker.stack.drainTo(mark_stack_);
+        }
+        return mark_stack_.empty();
+    }
+
+    void markByWorker(MarkWorker &worker, size_t idx, Clock::time_point deadline)
+    {
+        auto push_gray = [this, &worker](uint64_t &slot) {
+            auto *obj = reinterpret_cast<ObjectHeader *>(slot);
+            if (obj != nullptr && !heap_.isYoung(slot) && heap_.getOldSpace().markAtomic(obj)) {
+                worker.stack.push(obj);
             }
-            if (root->getGCState() == state) {
-                continue;
+        };
+        PrefetchQueue queue;
+        for (size_t scanned = 1;; scanned++) {
+            while (!queue.full()) {
+                auto *obj = worker.stack.pop();
+                if (obj == nullptr) {
+                    break;
+                }
+                __builtin_prefetch(obj, 1);
+                queue.push(obj);
             }
-            auto classWord = root->getClassWord();
-            if (classWord == stringClassWord_) {
-                // If we met string from root, we can not access anything else from it
-                // just mark string as alive object and move forward
-                root->setGCState(state);
+            if (queue.empty()) {
+                if (!stealWork(worker, idx)) {
+                    return;
+                }
                 continue;
             }
-            auto baseClass = reinterpret_cast<BaseClass *>(classWord);
-            if (baseClass->type == ARRAY) {
-                markArray(reinterpret_cast<Array *>(root), state);
+            auto *obj = queue.pop();
+            LOG_DEBUG("Mark " << obj, vm_->getLogLevel());
+            worker.live_bytes += obj->getObjectSize();
+            worker.live_objects++;
+            forEachRefSlot(obj, push_gray);
+            worker.stack.publish();
+            if (scanned % DEADLINE_CHECK_PERIOD == 0 && Clock::now() >= deadline) {
+                is_mark_stopped_.store(true, std::memory_order_relaxed);
             }
-            if (baseClass->type == DEFAULT) {
-                markClass(reinterpret_cast<Class *>(root), state);
+            if (is_mark_stopped_.load(std::memory_order_relaxed)) {
+                while (!queue.empty()) {
+                    worker.stack.push(queue.pop());
+                }
+                return;
             }
         }
     }
-    bool isMarked(ObjectHeader *obj)
+
+    // Take work published by other threads, return false when marking is over. Only busy threads
+    // publish work, so it is over once all of them are idle
+    bool stealWork(MarkWorker &thief, size_t idx)
     {
-        auto gcState = obj->getGCState();
-        return true ? gcState == MarkWord::GCState::MARKED : false;
+        size_t num_of_workers = mark_workers_.size();
+        num_of_idle_workers_.fetch_add(1);
+        while (!is_mark_stopped_.load(std::memory_order_relaxed)) {
+            for (size_t i = 1; i < num_of_workers; i++) {
+                auto &victim = mark_workers_[(idx + i) % num_of_workers];
+                if (!victim.stack.hasShared()) {
+                    continue;
+                }
+                num_of_idle_workers_.fetch_sub(1);
+                if (thief.stack.stealFrom(victim.stack)) {
+                    return true;
+                }
+                num_of_idle_workers_.fetch_add(1);
+            }
+            if (num_of_idle_workers_.load() == num_of_workers) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return false;
     }
-    void sweep()
+
+    // Objects are marked when pushed, so each of them is scanned once. Young objects are
+    // born after marking has started and are not marked
+    void pushGray(uint64_t ref)
     {
-        LOG_DEBUG("[BEFORE SWEEP] Amount of allocations : " << vm_->getAllocator().getAllocations().size(),
-                  vm_->getLogLevel());
-        auto &allocator = vm_->getAllocator();
-        LOG_DEBUG("Start of sweeping", vm_->getLogLevel());
-        auto &allocations = allocator.getAllocations();
-        std::list<AllocationInfo>::iterator objectInfo = allocations.begin();
-        while (objectInfo != allocations.end()) {
-            auto object = objectInfo->ptr;
-            auto size = objectInfo->size;
-            LOG_DEBUG("FOUND IN HEAP : " << std::hex << object << std::dec, vm_->getLogLevel());
-            bool is_marked = isMarked(reinterpret_cast<ObjectHeader *>(object));
-            if (is_marked) {
-                objectInfo++;
-            } else {
-                objectInfo = allocations.erase(objectInfo);
-                LOG_DEBUG("DEAD : " << std::hex << object << std::dec, vm_->getLogLevel());
-                allocator.deallocate(object, size);
+        auto *obj = reinterpret_cast<ObjectHeader *>(ref);
+        if (obj != nullptr && !heap_.isYoung(ref) && heap_.getOldSpace().mark(obj)) {
+            mark_stack_.push_back(obj);
+        }
+    }
+
+    // Visit reference slots of object: elements of reference arrays, reference fields,
+    // parents of string slices and parts of ropes
+    template <typename Visitor>
+    void forEachRefSlot(ObjectHeader *obj, Visitor visitor)
+    {
+        auto classWord = obj->getClassWord();
+        if (classWord == stringClassWord_) {
+            return;
+        }
+        auto baseClass = reinterpret_cast<BaseClass *>(classWord);
+        if (baseClass->type == STRING) {
+            auto *str = static_cast<String *>(obj);
+            for (uint32_t i = 0, num = str->getNumOfRefs(); i < num; i++) {
+                visitor(*str->getRefAddr(i));
+            }
+        } else if (baseClass->type == ARRAY) {
+            auto *arr = static_cast<Array *>(obj);
+            if (reinterpret_cast<RuntimeArray *>(classWord)->elem_type != ArrayElemType::REF) {
+                return;
+            }
+            for (uint32_t i = 0, size = arr->getSize(); i < size; i++) {
+                visitor(*arr->getElemAddr(i));
+            }
+        } else if (baseClass->type == DEFAULT) {
+            auto *klass = static_cast<Class *>(obj);
+            for (const auto &field : reinterpret_cast<RuntimeClass *>(classWord)->fields) {
+                if (field.is_ref) {
+                    visitor(*klass->getRefFieldAddr(field));
+                }
             }
         }
-        LOG_DEBUG("[AFTER SWEEP] Amount of allocations : " << vm_->getAllocator().getAllocations().size(),
-                  vm_->getLogLevel());
-        LOG_DEBUG("End of sweeping", vm_->getLogLevel());
+    }
+
+    // Unmarked objects are freed lazily by old space allocations out of pause
+    void sweep()
+    {
+        LOG_DEBUG("[BEFORE SWEEP] Amount of objects : " << heap_.getNumOfObjects(), vm_->getLogLevel());
+        heap_.getOldSpace().startSweep(live_bytes_, live_objects_);
+        LOG_DEBUG("[AFTER SWEEP] Amount of objects : " << heap_.getNumOfObjects(), vm_->getLogLevel());
     }
 
     std::vector<ObjectHeader *> roots_ {};
+    std::vector<ObjectHeader *> promoted_ {};
+    std::vector<ObjectHeader *> mark_stack_ {};
+    std::vector<ObjectHeader *> pinned_ {};
+    size_t live_bytes_ = 0;
+    size_t live_objects_ = 0;
+    // Parallel marking is used with more than one GC thread
+    std::unique_ptr<GCWorkers> workers_ {};
+    std::deque<MarkWorker> mark_workers_ {};
+    std::atomic<size_t> num_of_idle_workers_ {0};
+    std::atomic<bool> is_mark_stopped_ {false};
     ShrimpVM *vm_;
+    GenerationalHeap &heap_;
+    std::chrono::microseconds max_pause_;
     ClassWord stringClassWord_;
 };
 
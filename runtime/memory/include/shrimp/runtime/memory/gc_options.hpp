@@ -0,0 +1,21 @@
+#ifndef RUNTIME_MEMORY_GC_OPTIONS_HPP
+#define RUNTIME_MEMORY_GC_OPTIONS_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace shrimp::runtime::mem {
+
+struct GCOptions {
+    // Old space is marked incrementally in slices bounded by max pause, zero means stop-the-world marking
+    std::chrono::microseconds max_pause {0};
+    // Threads marking old space in parallel, including the one running mutator
+    size_t num_of_threads = 1;
+    // Heap starts with min size and grows up to max size as live objects need, only used memory is committed
+    size_t heap_min = size_t {64} << 20;
+    size_t heap_max = size_t {4} << 30;
+};
+
+}  // namespace shrimp::runtime::mem
+
+#endif  // RUNTIME_MEMORY_GC_OPTIONS_HPP
@@ -0,0 +1,97 @@
+#ifndef RUNTIME_MEMORY_GC_WORKERS_HPP
+#define RUNTIME_MEMORY_GC_WORKERS_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace shrimp::runtime::mem {
+
+// GC threads kept between pauses. Calling thread takes part in each task as worker 0
+class GCWorkers final {
+public:
+    explicit GCWorkers(size_t num_of_workers)
+    {
+        for (size_t idx = 1; idx < num_of_workers; idx++) {
+            threads_.emplace_back([this, idx] { loop(idx); });
+        }
+    }
+
+    GCWorkers(const GCWorkers &) = delete;
+    GCWorkers(GCWorkers &&) = delete;
+
+    GCWorkers &operator=(const GCWorkers &) = delete;
+    GCWorkers &operator=(GCWorkers &&) = delete;
+
+    ~GCWorkers()
+    {
+        {
+            std::lock_guard lock {mutex_};
+            is_stopping_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        return threads_.size() + 1;
+    }
+
+    // Run task with worker index on every worker, return when all of them are done
+    void run(const std::function<void(size_t)> &task)
+    {
+        {
+            std::lock_guard lock {mutex_};
+            task_ = &task;
+            pending_ = threads_.size();
+            generation_++;
+        }
+        start_cv_.notify_all();
+        task(0);
+        std::unique_lock lock {mutex_};
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+        task_ = nullptr;
+    }
+
+private:
+    void loop(size_t idx)
+    {
+        size_t seen_generation = 0;
+        while (true) {
+            const std::function<void(size_t)> *task = nullptr;
+            {
+                std::unique_lock lock {mutex_};
+                start_cv_.wait(lock, [&] { return is_stopping_ || generation_ != seen_generation; });
+                if (is_stopping_) {
+                    return;
+                }
+                seen_generation = generation_;
+                task = task_;
+            }
+            (*task)(idx);
+            std::lock_guard lock {mutex_};
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_ {};
+    std::mutex mutex_ {};
+    std::condition_variable start_cv_ {};
+    std::condition_variable done_cv_ {};
+    const std::function<void(size_t)> *task_ = nullptr;
+    size_t pending_ = 0;
+    size_t generation_ = 0;
+    bool is_stopping_ = false;
+};
+
+}  // namespace shrimp::runtime::mem
+
+#endif  // RUNTIME_MEMORY_GC_WORKERS_HPP
@@ -0,0 +1,240 @@
+#ifndef RUNTIME_MEMORY_GENERATIONAL_HEAP_HPP
+#define RUNTIME_MEMORY_GENERATIONAL_HEAP_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <vector>
+
+#include <shrimp/runtime/memory/card_table.hpp>
+#include <shrimp/runtime/memory/heap.hpp>
+#include <shrimp/runtime/memory/memory_resource.hpp>
+#include <shrimp/runtime/memory/nursery.hpp>
+#include <shrimp/runtime/memory/object_header.hpp>
+
+namespace shrimp::runtime {
+
+// VM heap split into generations: small objects are born in nursery collected by copying minor GC,
+// survivors and big objects live in mark-sweep old space, which is compacted when it gets fragmented
+class GenerationalHeap final : public std::pmr::memory_resource {
+public:
+    // Bigger objects are allocated in old space directly
+    static constexpr size_t MAX_NURSERY_OBJECT_SIZE = 0x2000;
+
+    // Heap takes min_size of arena at first and grows up to whole arena
+    GenerationalHeap(LimitedArena &arena, size_t nursery_size, size_t min_size)
+        : arena_(arena),
+          nursery_(arena, nursery_size),
+          old_space_(arena),
+          old_space_min_(min_size - nursery_size),
+          old_space_max_(arena.getLimit() - nursery_size),
+          old_space_limit_(old_space_min_),
+          cards_(arena.getBegin(), arena.getLimit())
+    {
+        // Values of non-reference registers are 32 bit, zero extended below 4Gb and negative i32 sign
+        // extended above user space addresses. Neither falls in nursery range, so minor GC tells
+        // references in ambiguous registers exactly, nursery above 4Gb lets most values skip range check
+        if (!isAboveValues(nursery_.getBegin())) {
+            std::cerr << "Nursery is placed in low 4Gb" << std::endl;
+            std::abort();
+        }
+    }
+
+    GenerationalHeap(const GenerationalHeap &) = delete;
+    GenerationalHeap(GenerationalHeap &&) = delete;
+
+    GenerationalHeap &operator=(const GenerationalHeap &) = delete;
+    GenerationalHeap &operator=(GenerationalHeap &&) = delete;
+
+    auto &getNursery() noexcept
+    {
+        return nursery_;
+    }
+
+    auto &getOldSpace() noexcept
+    {
+        return old_space_;
+    }
+
+    auto &getCardTable() noexcept
+    {
+        return cards_;
+    }
+
+    // End of memory taken from arena, nothing is placed above it
+    uint8_t *getArenaTop() const noexcept
+    {
+        return arena_.getTop();
+    }
+
+    size_t getAllocated() const noexcept
+    {
+        return nursery_.getUsed() + old_space_.getAllocated();
+    }
+
+    size_t getNumOfObjects() const noexcept
+    {
+        return nursery_.getNumOfObjects() + old_space_.getNumOfObjects();
+    }
+
+    // Next nursery allocation may fail, minor GC is needed
+    bool isNurseryFull() const noexcept
+    {
+        return nursery_.getFree() < MAX_NURSERY_OBJECT_SIZE;
+    }
+
+    // Major GC is needed before old space allocations fail
+    bool isOldSpaceFull() const noexcept
+    {
+        return 10 * old_space_.getAllocated() >= 9 * old_space_limit_ || isOldSpaceExhausted();
+    }
+
+    // Chunks exceed old space limit while free blocks do not fit requests, old space must be compacted.
+    // Chunks kept by pinned objects are not compacted again until new ones are taken
+    bool isOldSpaceExhausted() const noexcept
+    {
+        size_t footprint = old_space_.getFootprint();
+        return 20 * footprint >= 19 * old_space_limit_ && footprint > old_space_.getCompactedFootprint();
+    }
+
+    size_t getOldSpaceLimit() const noexcept
+    {
+        return old_space_limit_;
+    }
+
+    // Old space limit is set to twice amount of live objects after major GC once they take more than
+    // half or less than quarter of it, so major GCs are done after allocating as much as survived
+    void resizeOldSpace(size_t live_bytes) noexcept
+    {
+        if (2 * live_bytes > old_space_limit_ || 4 * live_bytes < old_space_limit_) {
+            old_space_limit_ = std::clamp(2 * live_bytes, old_space_min_, old_space_max_);
+        }
+    }
+
+    // Incremental marking starts before old space is full to finish in time
+    bool isOldSpaceFilling() const noexcept
+    {
+        return 10 * old_space_.getAllocated() >= 7 * old_space_limit_;
+    }
+
+    // Exact for ambiguous register values too, nursery range check rejects all non-references
+    bool isYoung(uint64_t ref) const noexcept
+    {
+        return isAboveValues(ref) && nursery_.contains(reinterpret_cast<void *>(ref));
+    }
+
+    // Must be called before reference old_ref stored in object is overwritten
+    void writeBarrier(const ObjectHeader *obj, uint64_t old_ref) noexcept
+    {
+        cards_.markCard(obj);
+        // Snapshot at the beginning: object unlinked while marking is in progress is kept,
+        // young objects are born after the snapshot
+        if (is_marking_ && old_ref != 0 && !isYoung(old_ref)) [[unlikely]] {
+            deleted_refs_.push_back(reinterpret_cast<ObjectHeader *>(old_ref));
+        }
+    }
+
+    // Old object, which may be unreachable since snapshot, is reached again through weak reference,
+    // e.g. intern table, so marking in progress must keep it
+    void keepAlive(uint64_t ref) noexcept
+    {
+        if (is_marking_ && !isYoung(ref)) [[unlikely]] {
+            deleted_refs_.push_back(reinterpret_cast<ObjectHeader *>(ref));
+        }
+    }
+
+    // Incremental GC step is requested after given amount of allocations
+    void requestStepAfter(size_t bytes) noexcept
+    {
+        step_budget_ = static_cast<int64_t>(bytes);
+    }
+
+    bool isStepDue() const noexcept
+    {
+        return step_budget_ <= 0;
+    }
+
+    bool isMarking() const noexcept
+    {
+        return is_marking_;
+    }
+
+    // Old space objects allocated until marking is finished are black
+    void startMarking() noexcept
+    {
+        is_marking_ = true;
+        old_space_.setAllocateBlack(true);
+    }
+
+    void finishMarking() noexcept
+    {
+        is_marking_ = false;
+        old_space_.setAllocateBlack(false);
+    }
+
+    // Old objects unlinked by mutator since last marking slice
+    auto &getDeletedRefs() noexcept
+    {
+        return deleted_refs_;
+    }
+
+    // Forwarding address of evacuated object is stored in mark word as offset in granules
+    uint32_t compressAddr(const ObjectHeader *obj) const noexcept
+    {
+        return (reinterpret_cast<const uint8_t *>(obj) - arena_.getBegin()) / GRANULE;
+    }
+
+    ObjectHeader *decompressAddr(uint32_t addr) const noexcept
+    {
+        return reinterpret_cast<ObjectHeader *>(arena_.getBegin() + size_t {addr} * GRANULE);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    static constexpr size_t GRANULE = 16;
+
+    template <typename T>
+    static bool isAboveValues(T ref) noexcept
+    {
+        return reinterpret_cast<uint64_t>(ref) > UINT32_MAX;
+    }
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        size_t size = Heap::getBlockSize(bytes);
+        step_budget_ -= static_cast<int64_t>(size);
+        if (size <= MAX_NURSERY_OBJECT_SIZE) [[likely]] {
+            if (auto *obj = nursery_.allocate(size); obj != nullptr) [[likely]] {
+                return obj;
+            }
+        }
+        return old_space_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        if (!nursery_.contains(p)) {
+            old_space_.deallocate(p, bytes, alignment);
+        }
+    }
+
+    LimitedArena &arena_;
+    Nursery nursery_;
+    Heap old_space_;
+    size_t old_space_min_ = 0;
+    size_t old_space_max_ = 0;
+    size_t old_space_limit_ = 0;
+    CardTable cards_;
+    int64_t step_budget_ = INT64_MAX;
+    bool is_marking_ = false;
+    std::vector<ObjectHeader *> deleted_refs_ {};
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // RUNTIME_MEMORY_GENERATIONAL_HEAP_HPP
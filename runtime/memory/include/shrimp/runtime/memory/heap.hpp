@@ -0,0 +1,565 @@
+#ifndef RUNTIME_MEMORY_HEAP_HPP
+#define RUNTIME_MEMORY_HEAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include <shrimp/runtime/memory/class_word.hpp>
+#include <shrimp/runtime/memory/memory_resource.hpp>
+#include <shrimp/runtime/memory/object_header.hpp>
+
+namespace shrimp::runtime {
+
+// Old space: objects are bump allocated in chunks taken from arena, freed blocks are
+// kept in segregated free lists by size class. Every block starts with ObjectHeader
+// holding block size, so chunks are walked linearly. Side bitmaps with bit per granule
+// keep starts of allocated objects to find objects of dirty cards and GC marks, so
+// tracing does not write object headers. Free blocks too small for requests are
+// reclaimed by sliding compaction, which gives emptied chunks back to arena
+class Heap final : public std::pmr::memory_resource {
+public:
+    explicit Heap(LimitedArena &arena)
+        : arena_(arena),
+          starts_((arena.getLimit() / GRANULE + BITS_PER_WORD - 1) / BITS_PER_WORD),
+          marks_(starts_.size())
+    {
+    }
+
+    Heap(const Heap &) = delete;
+    Heap(Heap &&) = delete;
+
+    Heap &operator=(const Heap &) = delete;
+    Heap &operator=(Heap &&) = delete;
+
+    // Bytes occupied by allocated objects
+    size_t getAllocated() const noexcept
+    {
+        return allocated_;
+    }
+
+    size_t getNumOfObjects() const noexcept
+    {
+        return num_of_objects_;
+    }
+
+    // Bytes of arena taken by chunks
+    size_t getFootprint() const noexcept
+    {
+        return footprint_;
+    }
+
+    // Chunks left by last compaction, pinned objects may keep chunks above live ones
+    size_t getCompactedFootprint() const noexcept
+    {
+        return compacted_footprint_;
+    }
+
+    // Size of block holding object of given size
+    static size_t getBlockSize(size_t bytes) noexcept
+    {
+        return std::max(alignUp(bytes), MIN_BLOCK_SIZE);
+    }
+
+    // Set mark bit of object, return false if it was already set
+    bool mark(const ObjectHeader *obj) noexcept
+    {
+        return testAndSet(marks_, reinterpret_cast<const uint8_t *>(obj));
+    }
+
+    // Same as mark, but safe for GC workers marking in parallel
+    bool markAtomic(const ObjectHeader *obj) noexcept
+    {
+        size_t granule = getGranule(reinterpret_cast<const uint8_t *>(obj));
+        uint64_t bit = uint64_t {1} << (granule % BITS_PER_WORD);
+        std::atomic_ref<uint64_t> word {marks_[granule / BITS_PER_WORD]};
+        if ((word.load(std::memory_order_relaxed) & bit) != 0) {
+            return false;
+        }
+        return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+
+    // Mark bit of object is set, valid after marking until chunk of object is swept
+    bool isMarked(const ObjectHeader *obj) const noexcept
+    {
+        size_t granule = getGranule(reinterpret_cast<const uint8_t *>(obj));
+        return ((marks_[granule / BITS_PER_WORD] >> (granule % BITS_PER_WORD)) & 1) != 0;
+    }
+
+    // Allocated object starts at address, which may be any value
+    bool isObjectStart(uint64_t addr) const noexcept
+    {
+        auto begin = reinterpret_cast<uint64_t>(arena_.getBegin());
+        if (addr < begin || addr - begin >= arena_.getLimit() || (addr - begin) % GRANULE != 0) {
+            return false;
+        }
+        size_t granule = (addr - begin) / GRANULE;
+        return ((starts_[granule / BITS_PER_WORD] >> (granule % BITS_PER_WORD)) & 1) != 0;
+    }
+
+    // Visit allocated objects started in [begin, end)
+    template <typename Visitor>
+    void forEachObjectIn(uint8_t *begin, uint8_t *end, Visitor visitor)
+    {
+        forEachBitIn(starts_, begin, end, visitor);
+    }
+
+    // Visit marked objects in address order
+    template <typename Visitor>
+    void forEachMarkedObject(Visitor visitor)
+    {
+        if (!chunks_.empty()) {
+            forEachBitIn(marks_, chunks_.front().begin, chunks_.back().end, visitor);
+        }
+    }
+
+    // First pass of sliding compaction after marking: marked objects get addresses they are
+    // moved to in mark word, keeping their order. Pinned objects stay in place, free space left
+    // in front of them and at ends of chunks is recorded to become free blocks
+    template <typename IsPinned>
+    void computeForwarding(IsPinned is_pinned)
+    {
+        assert(isSwept());
+        gaps_.clear();
+        compact_chunk_ = 0;
+        compact_top_ = chunks_.empty() ? nullptr : chunks_.front().begin;
+        // Move compaction top to the next chunk, the rest of current one is free
+        auto next_chunk = [this]() {
+            auto &chunk = chunks_[compact_chunk_++];
+            gaps_.emplace_back(compact_top_, chunk.end - compact_top_);
+            compact_top_ = chunks_[compact_chunk_].begin;
+        };
+        forEachMarkedObject([&](ObjectHeader *obj) {
+            auto *pos = reinterpret_cast<uint8_t *>(obj);
+            size_t size = obj->getObjectSize();
+            if (is_pinned(obj)) {
+                while (pos >= chunks_[compact_chunk_].end) {
+                    next_chunk();
+                }
+                gaps_.emplace_back(compact_top_, pos - compact_top_);
+                compact_top_ = pos + size;
+                obj->setForwardingAddr(getGranule(pos));
+                return;
+            }
+            // Objects never move up, so chunk of object itself fits it
+            while (static_cast<size_t>(chunks_[compact_chunk_].end - compact_top_) < size) {
+                next_chunk();
+            }
+            obj->setForwardingAddr(getGranule(compact_top_));
+            compact_top_ += size;
+        });
+    }
+
+    // Last pass of sliding compaction, references are updated by GC already. Objects are moved
+    // in address order, so each of them overwrites only already moved or dead ones
+    void compact() noexcept
+    {
+        if (chunks_.empty()) {
+            return;
+        }
+        uint8_t *begin = chunks_.front().begin;
+        uint8_t *end = chunks_.back().end;
+        clearBits(starts_, begin, end);
+        allocated_ = 0;
+        num_of_objects_ = 0;
+        forEachMarkedObject([this](ObjectHeader *obj) {
+            auto *dest = arena_.getBegin() + size_t {obj->getForwardingAddr()} * GRANULE;
+            size_t size = obj->getObjectSize();
+            if (dest != reinterpret_cast<uint8_t *>(obj)) {
+                std::memmove(dest, obj, size);
+            }
+            reinterpret_cast<ObjectHeader *>(dest)->clearForwardingAddr();
+            setStart(dest);
+            allocated_ += size;
+            num_of_objects_++;
+        });
+        clearBits(marks_, begin, end);
+        black_bytes_ = 0;
+        black_objects_ = 0;
+        small_lists_.fill(nullptr);
+        large_lists_.fill(nullptr);
+        // Chunks past compaction top are empty, they are released from the last one
+        while (chunks_.size() > compact_chunk_ + 1) {
+            auto &chunk = chunks_.back();
+            footprint_ -= chunk.end - chunk.begin;
+            arena_.deallocate(chunk.begin, chunk.end - chunk.begin, GRANULE);
+            chunks_.pop_back();
+        }
+        for (size_t idx = 0; idx < compact_chunk_; idx++) {
+            chunks_[idx].top = chunks_[idx].end;
+        }
+        chunks_.back().top = compact_top_;
+        compacted_footprint_ = footprint_;
+        sweep_cursor_ = chunks_.size();
+        sweep_end_ = chunks_.size();
+        for (auto [gap, size] : gaps_) {
+            addFreeBlock(gap, size);
+        }
+    }
+
+    // Allocated objects are marked, e.g. while incremental marking is in progress
+    void setAllocateBlack(bool allocate_black) noexcept
+    {
+        allocate_black_ = allocate_black;
+    }
+
+    // Start lazy sweeping of objects left unmarked by GC. Chunks are swept one by one when
+    // allocation misses free lists, objects allocated in unswept chunks meanwhile are marked.
+    // Live amount is given by marker, objects allocated black are counted here
+    void startSweep(size_t live_bytes, size_t live_objects) noexcept
+    {
+        small_lists_.fill(nullptr);
+        large_lists_.fill(nullptr);
+        allocated_ = live_bytes + black_bytes_;
+        num_of_objects_ = live_objects + black_objects_;
+        black_bytes_ = 0;
+        black_objects_ = 0;
+        sweep_cursor_ = 0;
+        sweep_end_ = chunks_.size();
+    }
+
+    bool isSwept() const noexcept
+    {
+        return sweep_cursor_ == sweep_end_;
+    }
+
+    // Free unmarked objects of next unswept chunk, coalesce adjacent free blocks into free lists
+    // and clear marks of live ones. Return false if all chunks are swept
+    bool sweepNextChunk() noexcept
+    {
+        if (isSwept()) {
+            return false;
+        }
+        auto &chunk = chunks_[sweep_cursor_++];
+        uint8_t *free_begin = nullptr;
+        for (uint8_t *pos = chunk.begin; pos != chunk.top;) {
+            auto *obj = reinterpret_cast<ObjectHeader *>(pos);
+            size_t size = obj->getObjectSize();
+            bool is_free = isFree(obj);
+            if (!is_free && testAndClear(marks_, pos)) {
+                if (free_begin != nullptr) {
+                    addFreeBlock(free_begin, pos - free_begin);
+                    free_begin = nullptr;
+                }
+            } else {
+                if (!is_free) {
+                    clearStart(pos);
+                }
+                if (free_begin == nullptr) {
+                    free_begin = pos;
+                }
+            }
+            pos += size;
+        }
+        if (free_begin != nullptr) {
+            // Free tail of current chunk goes back to bump space
+            if (&chunk == &chunks_.back()) {
+                chunk.top = free_begin;
+            } else {
+                addFreeBlock(free_begin, chunk.top - free_begin);
+            }
+        }
+        return true;
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+private:
+    static constexpr size_t GRANULE = 16;
+    // Free block holds header and free list link
+    static constexpr size_t MIN_BLOCK_SIZE = 32;
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+    // Exact size classes for blocks up to MAX_SMALL_SIZE, power of two classes for bigger ones
+    static constexpr size_t MAX_SMALL_SIZE = 512;
+    static constexpr size_t NUM_OF_SMALL_CLASSES = MAX_SMALL_SIZE / GRANULE + 1;
+    static constexpr size_t NUM_OF_LARGE_CLASSES = 64;
+    static constexpr ClassWord FREE_CLASS_WORD = 1;
+    static constexpr size_t BITS_PER_WORD = 64;
+
+    using Bitmap = ReservedArray<uint64_t>;
+
+    struct Chunk {
+        uint8_t *begin = nullptr;
+        uint8_t *end = nullptr;
+        uint8_t *top = nullptr;
+    };
+
+    struct FreeBlock : public ObjectHeader {
+        FreeBlock *next = nullptr;
+    };
+
+    static bool isFree(ObjectHeader *obj) noexcept
+    {
+        return obj->getClassWord() == FREE_CLASS_WORD;
+    }
+
+    static size_t alignUp(size_t size) noexcept
+    {
+        return (size + GRANULE - 1) & ~(GRANULE - 1);
+    }
+
+    static size_t getLargeClass(size_t size) noexcept
+    {
+        return std::bit_width(size) - 1;
+    }
+
+    void *do_allocate(size_t bytes, [[maybe_unused]] size_t alignment) override
+    {
+        assert(alignment <= GRANULE);
+        size_t size = getBlockSize(bytes);
+
+        uint8_t *block = nullptr;
+        if (size <= MAX_SMALL_SIZE && small_lists_[size / GRANULE] != nullptr) [[likely]] {
+            block = reinterpret_cast<uint8_t *>(popFreeBlock(small_lists_[size / GRANULE]));
+        } else {
+            block = bump(size);
+        }
+        if (block == nullptr) [[unlikely]] {
+            block = allocateSlow(size);
+            if (block == nullptr) {
+                return nullptr;
+            }
+        }
+
+        std::memset(block, 0, size);
+        reinterpret_cast<ObjectHeader *>(block)->setObjectSize(size);
+        setStart(block);
+        if (allocate_black_) [[unlikely]] {
+            testAndSet(marks_, block);
+            black_bytes_ += size;
+            black_objects_++;
+        } else if (isUnswept(block)) [[unlikely]] {
+            // Sweep of its chunk must not free it
+            testAndSet(marks_, block);
+        }
+        allocated_ += size;
+        num_of_objects_++;
+        return block;
+    }
+
+    void do_deallocate(void *p, size_t /*bytes*/, size_t /*alignment*/) override
+    {
+        auto *obj = static_cast<ObjectHeader *>(p);
+        size_t size = obj->getObjectSize();
+        allocated_ -= size;
+        num_of_objects_--;
+        clearStart(static_cast<uint8_t *>(p));
+        addFreeBlock(static_cast<uint8_t *>(p), size);
+    }
+
+    size_t getGranule(const uint8_t *pos) const noexcept
+    {
+        return (pos - arena_.getBegin()) / GRANULE;
+    }
+
+    // Visit objects whose bits are set in [begin, end)
+    template <typename Visitor>
+    void forEachBitIn(const Bitmap &bits, uint8_t *begin, uint8_t *end, Visitor visitor)
+    {
+        size_t first = getGranule(begin);
+        size_t last = std::min(getGranule(end), bits.size() * BITS_PER_WORD);
+        for (size_t word_idx = first / BITS_PER_WORD; word_idx * BITS_PER_WORD < last; word_idx++) {
+            uint64_t word = bits[word_idx];
+            for (; word != 0; word &= word - 1) {
+                size_t granule = word_idx * BITS_PER_WORD + std::countr_zero(word);
+                if (granule >= first && granule < last) {
+                    visitor(reinterpret_cast<ObjectHeader *>(arena_.getBegin() + granule * GRANULE));
+                }
+            }
+        }
+    }
+
+    // Clear bits of granules in [begin, end), both are chunk bounds
+    void clearBits(Bitmap &bits, const uint8_t *begin, const uint8_t *end) noexcept
+    {
+        for (size_t granule = getGranule(begin), last = getGranule(end); granule < last;) {
+            if (granule % BITS_PER_WORD == 0 && granule + BITS_PER_WORD <= last) {
+                bits[granule / BITS_PER_WORD] = 0;
+                granule += BITS_PER_WORD;
+            } else {
+                bits[granule / BITS_PER_WORD] &= ~(uint64_t {1} << (granule % BITS_PER_WORD));
+                granule++;
+            }
+        }
+    }
+
+    // Set bit of granule at pos, return false if it was already set
+    bool testAndSet(Bitmap &bits, const uint8_t *pos) noexcept
+    {
+        size_t granule = getGranule(pos);
+        uint64_t bit = uint64_t {1} << (granule % BITS_PER_WORD);
+        uint64_t &word = bits[granule / BITS_PER_WORD];
+        if ((word & bit) != 0) {
+            return false;
+        }
+        word |= bit;
+        return true;
+    }
+
+    // Clear bit of granule at pos, return true if it was set
+    bool testAndClear(Bitmap &bits, const uint8_t *pos) noexcept
+    {
+        size_t granule = getGranule(pos);
+        uint64_t bit = uint64_t {1} << (granule % BITS_PER_WORD);
+        uint64_t &word = bits[granule / BITS_PER_WORD];
+        bool was_set = (word & bit) != 0;
+        word &= ~bit;
+        return was_set;
+    }
+
+    void setStart(const uint8_t *pos) noexcept
+    {
+        testAndSet(starts_, pos);
+    }
+
+    void clearStart(const uint8_t *pos) noexcept
+    {
+        testAndClear(starts_, pos);
+    }
+
+    // Block belongs to chunk that is not swept yet since last marking
+    bool isUnswept(const uint8_t *pos) const noexcept
+    {
+        if (isSwept()) [[likely]] {
+            return false;
+        }
+        auto it = std::upper_bound(chunks_.begin(), chunks_.end(), pos,
+                                   [](const uint8_t *p, const Chunk &chunk) { return p < chunk.begin; });
+        size_t idx = it - chunks_.begin() - 1;
+        return idx >= sweep_cursor_ && idx < sweep_end_;
+    }
+
+    uint8_t *bump(size_t size) noexcept
+    {
+        if (chunks_.empty()) {
+            return nullptr;
+        }
+        auto &chunk = chunks_.back();
+        if (static_cast<size_t>(chunk.end - chunk.top) < size) {
+            return nullptr;
+        }
+        uint8_t *block = chunk.top;
+        chunk.top += size;
+        return block;
+    }
+
+    // Take block from bigger free lists, from lazily swept chunks or from new chunk
+    uint8_t *allocateSlow(size_t size)
+    {
+        if (auto *block = findFit(size); block != nullptr) {
+            return block;
+        }
+        while (sweepNextChunk()) {
+            if (auto *block = findFit(size); block != nullptr) {
+                return block;
+            }
+            if (auto *block = bump(size); block != nullptr) {
+                return block;
+            }
+        }
+        size_t chunk_size = std::max(CHUNK_SIZE, size);
+        auto *begin = static_cast<uint8_t *>(arena_.allocate(chunk_size, GRANULE));
+        if (begin == nullptr) {
+            return nullptr;
+        }
+        if (!chunks_.empty()) {
+            auto &prev = chunks_.back();
+            addFreeBlock(prev.top, prev.end - prev.top);
+            prev.top = prev.end;
+        }
+        chunks_.push_back(Chunk {begin, begin + chunk_size, begin});
+        footprint_ += chunk_size;
+        return bump(size);
+    }
+
+    uint8_t *findFit(size_t size)
+    {
+        if (size <= MAX_SMALL_SIZE) {
+            // Exact class is empty, split bigger block leaving at least MIN_BLOCK_SIZE
+            for (size_t cls = (size + MIN_BLOCK_SIZE) / GRANULE; cls < NUM_OF_SMALL_CLASSES; cls++) {
+                if (small_lists_[cls] != nullptr) {
+                    return splitBlock(popFreeBlock(small_lists_[cls]), size);
+                }
+            }
+        }
+        for (size_t cls = getLargeClass(size); cls < NUM_OF_LARGE_CLASSES; cls++) {
+            for (FreeBlock **link = &large_lists_[cls]; *link != nullptr; link = &(*link)->next) {
+                size_t block_size = (*link)->getObjectSize();
+                if (block_size == size || block_size >= size + MIN_BLOCK_SIZE) {
+                    return splitBlock(popFreeBlock(*link), size);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    uint8_t *splitBlock(FreeBlock *block, size_t size)
+    {
+        auto *begin = reinterpret_cast<uint8_t *>(block);
+        size_t block_size = block->getObjectSize();
+        if (block_size > size) {
+            addFreeBlock(begin + size, block_size - size);
+        }
+        return begin;
+    }
+
+    static FreeBlock *popFreeBlock(FreeBlock *&head) noexcept
+    {
+        FreeBlock *block = head;
+        head = block->next;
+        return block;
+    }
+
+    // Make [begin, begin + size) walkable free block, blocks too small for link are never reused.
+    // Blocks of unswept chunks are linked by their sweep
+    void addFreeBlock(uint8_t *begin, size_t size) noexcept
+    {
+        if (size == 0) {
+            return;
+        }
+        auto *block = reinterpret_cast<FreeBlock *>(begin);
+        block->setClassWord(FREE_CLASS_WORD);
+        block->setObjectSize(size);
+        if (size < MIN_BLOCK_SIZE || isUnswept(begin)) {
+            return;
+        }
+        FreeBlock *&head = size <= MAX_SMALL_SIZE ? small_lists_[size / GRANULE] : large_lists_[getLargeClass(size)];
+        block->next = head;
+        head = block;
+    }
+
+    LimitedArena &arena_;
+    std::vector<Chunk> chunks_ {};
+    Bitmap starts_;
+    Bitmap marks_;
+    std::array<FreeBlock *, NUM_OF_SMALL_CLASSES> small_lists_ {};
+    std::array<FreeBlock *, NUM_OF_LARGE_CLASSES> large_lists_ {};
+    size_t allocated_ = 0;
+    size_t num_of_objects_ = 0;
+    bool allocate_black_ = false;
+    size_t black_bytes_ = 0;
+    size_t black_objects_ = 0;
+    // Chunks [sweep_cursor_, sweep_end_) are not swept since last marking
+    size_t sweep_cursor_ = 0;
+    size_t sweep_end_ = 0;
+    size_t footprint_ = 0;
+    size_t compacted_footprint_ = 0;
+    // Free ranges and end of live objects after compaction
+    std::vector<std::pair<uint8_t *, size_t>> gaps_ {};
+    size_t compact_chunk_ = 0;
+    uint8_t *compact_top_ = nullptr;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // RUNTIME_MEMORY_HEAP_HPP
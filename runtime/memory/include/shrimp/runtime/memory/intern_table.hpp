@@ -0,0 +1,147 @@
+#ifndef RUNTIME_MEMORY_INTERN_TABLE_HPP
+#define RUNTIME_MEMORY_INTERN_TABLE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace shrimp::runtime {
+
+// Weak set of interned strings: open addressing table of references with their hash codes.
+// It does not keep strings alive, GC updates references of moved strings and removes dead ones
+class InternTable final {
+public:
+    // Get reference with given hash for which is_equal is true or zero if there is none
+    template <typename IsEqual>
+    uint64_t find(uint32_t hash, IsEqual is_equal) const
+    {
+        if (entries_.empty()) {
+            return 0;
+        }
+        for (size_t idx = hash & getMask(); entries_[idx].ref != EMPTY; idx = (idx + 1) & getMask()) {
+            const auto &entry = entries_[idx];
+            if (entry.ref != REMOVED && entry.hash == hash && is_equal(entry.ref)) {
+                return entry.ref;
+            }
+        }
+        return 0;
+    }
+
+    // Young references are remembered, so minor GC updates them without scanning whole table
+    void insert(uint32_t hash, uint64_t ref, bool is_young)
+    {
+        if (4 * (used_ + 1) > 3 * entries_.size()) {
+            rehash();
+        }
+        place(hash, ref);
+        size_++;
+        used_++;
+        if (is_young) {
+            young_.push_back({ref, hash});
+        }
+    }
+
+    // Update young references, update returns reference to moved string or zero if string is dead
+    template <typename Update>
+    void updateYoung(Update update)
+    {
+        for (auto [ref, hash] : young_) {
+            auto *entry = findEntry(hash, ref);
+            if (entry != nullptr) {
+                setRef(*entry, update(ref));
+            }
+        }
+        young_.clear();
+    }
+
+    // Update all references as updateYoung does, young ones are left in place
+    template <typename Update>
+    void updateAll(Update update)
+    {
+        for (auto &entry : entries_) {
+            if (entry.ref != EMPTY && entry.ref != REMOVED) {
+                setRef(entry, update(entry.ref));
+            }
+        }
+        // Removed entries make searches longer until they are dropped
+        if (used_ > 2 * size_) {
+            rehash();
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        return size_;
+    }
+
+private:
+    static constexpr uint64_t EMPTY = 0;
+    // Not valid reference, searches go on past removed entries
+    static constexpr uint64_t REMOVED = 1;
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct Entry {
+        uint64_t ref = EMPTY;
+        uint32_t hash = 0;
+    };
+
+    size_t getMask() const noexcept
+    {
+        return entries_.size() - 1;
+    }
+
+    Entry *findEntry(uint32_t hash, uint64_t ref) noexcept
+    {
+        for (size_t idx = hash & getMask(); entries_[idx].ref != EMPTY; idx = (idx + 1) & getMask()) {
+            if (entries_[idx].ref == ref) {
+                return &entries_[idx];
+            }
+        }
+        return nullptr;
+    }
+
+    void place(uint32_t hash, uint64_t ref) noexcept
+    {
+        size_t idx = hash & getMask();
+        while (entries_[idx].ref != EMPTY) {
+            idx = (idx + 1) & getMask();
+        }
+        entries_[idx] = Entry {ref, hash};
+    }
+
+    void setRef(Entry &entry, uint64_t ref) noexcept
+    {
+        if (ref == 0) {
+            entry.ref = REMOVED;
+            size_--;
+        } else {
+            entry.ref = ref;
+        }
+    }
+
+    // Table is rebuilt without removed entries and is at most quarter full after it
+    void rehash()
+    {
+        auto old_entries = std::move(entries_);
+        entries_.assign(std::max(MIN_CAPACITY, std::bit_ceil(4 * (size_ + 1))), Entry {});
+        for (const auto &entry : old_entries) {
+            if (entry.ref != EMPTY && entry.ref != REMOVED) {
+                place(entry.hash, entry.ref);
+            }
+        }
+        used_ = size_;
+    }
+
+    std::vector<Entry> entries_ {};
+    // Young references added since last minor GC
+    std::vector<std::pair<uint64_t, uint32_t>> young_ {};
+    size_t size_ = 0;
+    // Live and removed entries
+    size_t used_ = 0;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // RUNTIME_MEMORY_INTERN_TABLE_HPP
@@ -59,6 +59,46 @@ public:
         value_ = value_ & (~GC_STATUS_MASK_IN_PLACE);
     }
 
+    // Hash code of object is computed and stored in hash bits, only its low HASH_STATUS_SIZE bits are kept
+    bool isHashed() const
+    {
+        return ((value_ >> STATUS_SHIFT) & STATUS_MASK) == STATUS_HASHED;
+    }
+
+    uint32_t getHash() const
+    {
+        return (value_ & HASH_STATE_MASK_IN_PLACE) >> HASH_STATE_SHIFT;
+    }
+
+    void setHash(uint32_t hash)
+    {
+        value_ = (value_ & ~(STATUS_MASK_IN_PLACE | HASH_STATE_MASK_IN_PLACE)) |
+                 ((hash & HASH_STATE_MASK) << HASH_STATE_SHIFT) | (STATUS_HASHED << STATUS_SHIFT);
+    }
+
+    // Object was evacuated by copying GC, mark word holds compressed address of the copy
+    bool isForwarded() const
+    {
+        return ((value_ >> STATUS_SHIFT) & STATUS_MASK) == STATUS_GC;
+    }
+
+    uint32_t getForwardingAddr() const
+    {
+        return (value_ & FORWARDING_ADDR_MASK_IN_PLACE) >> FORWARDING_ADDR_SHIFT;
+    }
+
+    void setForwardingAddr(uint32_t addr)
+    {
+        value_ = ((addr & FORWARDING_ADDR_MASK) << FORWARDING_ADDR_SHIFT) | (STATUS_GC << STATUS_SHIFT);
+    }
+
+    // Object was moved by compacting GC, mark word gets back to unlocked state, so hash code
+    // is computed again when requested
+    void clearForwardingAddr()
+    {
+        value_ = 0;
+    }
+
 private:
     enum MarkWordUtils : uint32_t {
         MARK_WORD_SIZE = 32,
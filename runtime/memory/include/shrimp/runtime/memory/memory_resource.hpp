@@ -1,29 +1,48 @@
 #ifndef RUNTIME_MEMORY_MEMORY_RESOURCE_HPP
 #define RUNTIME_MEMORY_MEMORY_RESOURCE_HPP
 
-#include <list>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
 #include <memory_resource>
 
+#include <sys/mman.h>
+
 #include <shrimp/common/types.hpp>
 
 namespace shrimp::runtime {
 
-// Allocates raw memory blocks until limit is reached
+// Allocates raw memory blocks until limit is reached. Address range of limit size is reserved
+// up front, its pages are committed as blocks are allocated and given back to OS when
+// blocks on top are released
 class LimitedArena final : public std::pmr::memory_resource {
     void *begin_ = nullptr;
     void *curr_pos_ = nullptr;
     size_t space_ = 0;
+    size_t limit_ = 0;
+    uint8_t *committed_end_ = nullptr;
+
+    // Multiple of page size on supported platforms
+    static constexpr size_t COMMIT_SIZE = 0x10000;
 
 public:
-    LimitedArena(size_t limit) : begin_(new uint8_t[limit]), curr_pos_(begin_), space_(limit)
+    LimitedArena(size_t limit) : space_(limit), limit_(limit)
     {
         assert(limit != 0);
-        assert(begin_ != nullptr);
+        begin_ = mmap(nullptr, limit, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (begin_ == MAP_FAILED) {
+            std::cerr << "Failed to reserve heap" << std::endl;
+            std::abort();
+        }
+        curr_pos_ = begin_;
+        committed_end_ = getBegin();
     }
 
     ~LimitedArena()
     {
-        delete[] static_cast<uint8_t *>(begin_);
+        munmap(begin_, limit_);
     }
 
     LimitedArena(const LimitedArena &) = delete;
@@ -32,6 +51,27 @@ public:
     LimitedArena &operator=(const LimitedArena &) = delete;
     LimitedArena &operator=(LimitedArena &&) = delete;
 
+    uint8_t *getBegin() const noexcept
+    {
+        return static_cast<uint8_t *>(begin_);
+    }
+
+    // End of allocated blocks
+    uint8_t *getTop() const noexcept
+    {
+        return static_cast<uint8_t *>(curr_pos_);
+    }
+
+    size_t getLimit() const noexcept
+    {
+        return limit_;
+    }
+
+    size_t getCommitted() const noexcept
+    {
+        return committed_end_ - getBegin();
+    }
+
     void *do_allocate(size_t bytes, size_t alignment) override
     {
         void *aligned_pos = std::align(alignment, bytes, curr_pos_, space_);
@@ -40,69 +80,118 @@ public:
             return nullptr;
         }
 
-        curr_pos_ = static_cast<uint8_t *>(curr_pos_) + bytes;
+        auto *end = static_cast<uint8_t *>(aligned_pos) + bytes;
+        if (end > committed_end_ && !commit(end)) {
+            return nullptr;
+        }
+
+        curr_pos_ = end;
         space_ -= bytes;
 
         return aligned_pos;
     }
 
-    void do_deallocate(void * /*p*/, size_t /*bytes*/, size_t /*alignment*/) override
+    // Only block on top of arena is given back, so blocks released in reverse order are reused
+    void do_deallocate(void *p, size_t bytes, size_t /*alignment*/) override
     {
-        /* do nothing */
+        if (static_cast<uint8_t *>(p) + bytes == curr_pos_) {
+            curr_pos_ = p;
+            space_ += bytes;
+            decommit();
+        }
     }
 
     bool do_is_equal(const memory_resource &other) const noexcept override
     {
         return this == &other;
     }
-};
 
-struct AllocationInfo final {
-    void *ptr = nullptr;
-    size_t size = 0;
-};
+private:
+    uint8_t *alignToCommit(uint8_t *pos) const noexcept
+    {
+        size_t offset = (pos - getBegin() + COMMIT_SIZE - 1) & ~(COMMIT_SIZE - 1);
+        return getBegin() + std::min(offset, limit_);
+    }
 
-class LimitedMemRes final : public std::pmr::memory_resource {
-    size_t allocated_ = 0;
-    std::list<AllocationInfo> allocations_;
-    std::pmr::unsynchronized_pool_resource allocator_ {};
+    // Make pages up to end accessible
+    bool commit(uint8_t *end) noexcept
+    {
+        uint8_t *new_end = alignToCommit(end);
+        if (mprotect(committed_end_, new_end - committed_end_, PROT_READ | PROT_WRITE) != 0) {
+            return false;
+        }
+        committed_end_ = new_end;
+        return true;
+    }
 
-    void *do_allocate(size_t bytes, size_t alignment) override
+    // Give pages above allocated blocks back to OS
+    void decommit() noexcept
     {
-        void *out = allocator_.allocate(bytes, alignment);
+        uint8_t *new_end = alignToCommit(getTop());
+        if (new_end == committed_end_) {
+            return;
+        }
+        madvise(new_end, committed_end_ - new_end, MADV_DONTNEED);
+        mprotect(new_end, committed_end_ - new_end, PROT_NONE);
+        committed_end_ = new_end;
+    }
+};
 
-        if (out != nullptr) {
-            allocations_.push_back(AllocationInfo {out, bytes});
-            allocated_ += bytes;
+// Zeroed array placed in reserved address range, its pages are committed on first touch,
+// so side tables covering whole heap cost memory only for used part of it
+template <typename T>
+class ReservedArray final {
+public:
+    explicit ReservedArray(size_t size) : size_(size)
+    {
+        void *mem = mmap(nullptr, getBytes(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                         -1, 0);
+        if (mem == MAP_FAILED) {
+            std::cerr << "Failed to reserve heap side table" << std::endl;
+            std::abort();
         }
+        data_ = static_cast<T *>(mem);
+    }
 
-        return out;
+    ~ReservedArray()
+    {
+        munmap(data_, getBytes());
     }
 
-    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    ReservedArray(const ReservedArray &) = delete;
+    ReservedArray(ReservedArray &&) = delete;
+
+    ReservedArray &operator=(const ReservedArray &) = delete;
+    ReservedArray &operator=(ReservedArray &&) = delete;
+
+    T &operator[](size_t idx) noexcept
     {
-        allocator_.deallocate(p, bytes, alignment);
-        allocated_ -= bytes;
-        // allocations_ are changed by GC
+        return data_[idx];
     }
 
-public:
-    LimitedMemRes(LimitedArena &arena) : allocator_(&arena) {}
+    const T &operator[](size_t idx) const noexcept
+    {
+        return data_[idx];
+    }
 
-    auto &getAllocated() noexcept
+    T *data() noexcept
     {
-        return allocated_;
+        return data_;
     }
 
-    auto &getAllocations() noexcept
+    size_t size() const noexcept
     {
-        return allocations_;
+        return size_;
     }
 
-    bool do_is_equal(const memory_resource &other) const noexcept override
+private:
+    size_t getBytes() const noexcept
     {
-        return this == &other;
+        return std::max(size_ * sizeof(T), size_t {1});
     }
+
+    T *data_ = nullptr;
+    size_t size_ = 0;
 };
 
 }  // namespace shrimp::runtime
@@ -0,0 +1,91 @@
+#ifndef RUNTIME_MEMORY_NURSERY_HPP
+#define RUNTIME_MEMORY_NURSERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <shrimp/runtime/memory/memory_resource.hpp>
+#include <shrimp/runtime/memory/object_header.hpp>
+
+namespace shrimp::runtime {
+
+// Young generation: objects are bump allocated, survivors are evacuated to old space
+// by minor GC and whole nursery is reused afterwards
+class Nursery final {
+public:
+    Nursery(LimitedArena &arena, size_t size)
+    {
+        begin_ = static_cast<uint8_t *>(arena.allocate(size, alignof(std::max_align_t)));
+        if (begin_ == nullptr) {
+            std::cerr << "Failed to allocate nursery" << std::endl;
+            std::abort();
+        }
+        top_ = begin_;
+        end_ = begin_ + size;
+    }
+
+    Nursery(const Nursery &) = delete;
+    Nursery(Nursery &&) = delete;
+
+    Nursery &operator=(const Nursery &) = delete;
+    Nursery &operator=(Nursery &&) = delete;
+
+    // Allocate zeroed block of already aligned size or nullptr if nursery is full
+    ObjectHeader *allocate(size_t size) noexcept
+    {
+        if (static_cast<size_t>(end_ - top_) < size) [[unlikely]] {
+            return nullptr;
+        }
+        uint8_t *block = top_;
+        top_ += size;
+        std::memset(block, 0, size);
+        auto *obj = reinterpret_cast<ObjectHeader *>(block);
+        obj->setObjectSize(size);
+        num_of_objects_++;
+        return obj;
+    }
+
+    bool contains(const void *ptr) const noexcept
+    {
+        auto *pos = static_cast<const uint8_t *>(ptr);
+        return pos >= begin_ && pos < end_;
+    }
+
+    uint8_t *getBegin() const noexcept
+    {
+        return begin_;
+    }
+
+    size_t getUsed() const noexcept
+    {
+        return top_ - begin_;
+    }
+
+    size_t getFree() const noexcept
+    {
+        return end_ - top_;
+    }
+
+    size_t getNumOfObjects() const noexcept
+    {
+        return num_of_objects_;
+    }
+
+    void reset() noexcept
+    {
+        top_ = begin_;
+        num_of_objects_ = 0;
+    }
+
+private:
+    uint8_t *begin_ = nullptr;
+    uint8_t *top_ = nullptr;
+    uint8_t *end_ = nullptr;
+    size_t num_of_objects_ = 0;
+};
+
+}  // namespace shrimp::runtime
+
+#endif  // RUNTIME_MEMORY_NURSERY_HPP
@@ -16,6 +16,15 @@ public:
     {
         return classWord_;
     }
+    // Size of heap block occupied by object
+    uint32_t getObjectSize() const
+    {
+        return objectSize_;
+    }
+    void setObjectSize(uint32_t objectSize)
+    {
+        objectSize_ = objectSize;
+    }
     auto getState() const
     {
         return markWord_.getState();
@@ -24,6 +33,34 @@ public:
     {
         return markWord_.getGCState();
     }
+    bool isHashed() const
+    {
+        return markWord_.isHashed();
+    }
+    uint32_t getHash() const
+    {
+        return markWord_.getHash();
+    }
+    void setHash(uint32_t hash)
+    {
+        markWord_.setHash(hash);
+    }
+    bool isForwarded() const
+    {
+        return markWord_.isForwarded();
+    }
+    uint32_t getForwardingAddr() const
+    {
+        return markWord_.getForwardingAddr();
+    }
+    void setForwardingAddr(uint32_t addr)
+    {
+        markWord_.setForwardingAddr(addr);
+    }
+    void clearForwardingAddr()
+    {
+        markWord_.clearForwardingAddr();
+    }
     void setGCState(MarkWord::GCState state)
     {
         switch (state) {
@@ -41,6 +78,7 @@ public:
 
 private:
     MarkWord markWord_;
+    uint32_t objectSize_ {0};
     ClassWord classWord_;
 };
 
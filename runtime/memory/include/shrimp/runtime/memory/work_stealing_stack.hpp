@@ -0,0 +1,101 @@
+#ifndef RUNTIME_MEMORY_WORK_STEALING_STACK_HPP
+#define RUNTIME_MEMORY_WORK_STEALING_STACK_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <shrimp/runtime/memory/object_header.hpp>
+
+namespace shrimp::runtime::mem {
+
+// Mark stack of GC worker. Owner pushes and pops its local part without locking and
+// publishes the oldest entries, roots of biggest subgraphs, for idle workers to steal
+class WorkStealingStack final {
+public:
+    void push(ObjectHeader *obj)
+    {
+        local_.push_back(obj);
+    }
+
+    // Take object from local part or reclaim published one, nullptr if there are none
+    ObjectHeader *pop()
+    {
+        if (local_.empty() && !reclaim()) {
+            return nullptr;
+        }
+        auto *obj = local_.back();
+        local_.pop_back();
+        return obj;
+    }
+
+    // Publish part of local entries once previous ones are taken
+    void publish()
+    {
+        if (local_.size() < 2 * MIN_PUBLISH_SIZE || shared_size_.load(std::memory_order_relaxed) != 0) {
+            return;
+        }
+        std::lock_guard lock {mutex_};
+        size_t size = local_.size() / 2;
+        shared_.assign(local_.begin(), local_.begin() + size);
+        local_.erase(local_.begin(), local_.begin() + size);
+        shared_size_.store(size, std::memory_order_relaxed);
+    }
+
+    bool hasShared() const noexcept
+    {
+        return shared_size_.load(std::memory_order_relaxed) != 0;
+    }
+
+    // Move half of entries published by victim to local part, return false if there were none
+    bool stealFrom(WorkStealingStack &victim)
+    {
+        std::lock_guard lock {victim.mutex_};
+        size_t size = victim.shared_.size();
+        if (size == 0) {
+            return false;
+        }
+        size_t taken = (size + 1) / 2;
+        local_.insert(local_.end(), victim.shared_.end() - taken, victim.shared_.end());
+        victim.shared_.resize(size - taken);
+        victim.shared_size_.store(size - taken, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Move all entries out, e.g. when marking slice is over
+    void drainTo(std::vector<ObjectHeader *> &out)
+    {
+        out.insert(out.end(), local_.begin(), local_.end());
+        local_.clear();
+        std::lock_guard lock {mutex_};
+        out.insert(out.end(), shared_.begin(), shared_.end());
+        shared_.clear();
+        shared_size_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t MIN_PUBLISH_SIZE = 16;
+
+    bool reclaim()
+    {
+        if (!hasShared()) {
+            return false;
+        }
+        std::lock_guard lock {mutex_};
+        local_.insert(local_.end(), shared_.begin(), shared_.end());
+        shared_.clear();
+        shared_size_.store(0, std::memory_order_relaxed);
+        return !local_.empty();
+    }
+
+    std::deque<ObjectHeader *> local_ {};
+    std::mutex mutex_ {};
+    std::vector<ObjectHeader *> shared_ {};
+    std::atomic<size_t> shared_size_ {0};
+};
+
+}  // namespace shrimp::runtime::mem
+
+#endif  // RUNTIME_MEMORY_WORK_STEALING_STACK_HPP
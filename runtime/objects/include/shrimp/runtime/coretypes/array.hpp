@@ -14,16 +14,14 @@ class Array : public ObjectHeader {
 public:
     static Array *AllocateArrayRef(const RuntimeClass &classStruct, uint32_t size, ShrimpVM *vm)
     {
-        auto ptr = AllocateArray(reinterpret_cast<ClassWord>(&classStruct), size, vm);
+        auto ptr = AllocateArray(vm->getRefArrayClass(classStruct), size, vm);
         return ptr;
     }
-    static Array *AllocateArray(ClassWord classWord, uint32_t size, ShrimpVM *vm)
+    static Array *AllocateArray(const RuntimeArray &arrayClass, uint32_t size, ShrimpVM *vm)
     {
         auto ptr = reinterpret_cast<Array *>(
-            vm->getAllocator().allocate(sizeof(ObjectHeader) + sizeof(size) + size * sizeof(uint64_t)));
-        vm->getArrays().push_back(
-            RuntimeArray {{BaseClassType::ARRAY}, size, reinterpret_cast<RuntimeClass *>(classWord)});
-        ClassWord arrayClassWord = reinterpret_cast<ClassWord>(&vm->getArrays().back());
+            vm->getAllocator().allocate(sizeof(Array) + size * GetElemSize(arrayClass.elem_type)));
+        ClassWord arrayClassWord = reinterpret_cast<ClassWord>(&arrayClass);
         if (ptr != nullptr) {
             ptr->setSize(size);
             ptr->setClassWord(arrayClassWord);
@@ -33,20 +31,26 @@ public:
         LOG_INFO("data : " << ptr->getData(), vm->getLogLevel());
         return ptr;
     }
-    uint64_t getElem(uint32_t pos)
+    // i32 and f elements are stored unboxed in 4 bytes, references take 8
+    static constexpr size_t GetElemSize(ArrayElemType elemType)
     {
-        return data_[pos];
+        return elemType == ArrayElemType::REF ? sizeof(uint64_t) : sizeof(uint32_t);
     }
-    void setElem(uint64_t value, uint32_t pos)
+    template <typename T>
+    T getElem(uint32_t pos)
     {
-        data_[pos] = value;
+        return *getElemAddr<T>(pos);
     }
-    void setData(uint64_t *data)
+    template <typename T>
+    void setElem(T value, uint32_t pos)
     {
-        if (data == nullptr) {
-            return;
-        }
-        memcpy(data_, data, size_);
+        *getElemAddr<T>(pos) = value;
+    }
+    template <typename T = uint64_t>
+    T *getElemAddr(uint32_t pos)
+    {
+        static_assert(sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t));
+        return reinterpret_cast<T *>(data_) + pos;
     }
     void setSize(uint32_t size)
     {
@@ -56,7 +60,11 @@ public:
     {
         return size_;
     }
-    const uint64_t *getData() const
+    ArrayElemType getElemType()
+    {
+        return reinterpret_cast<const RuntimeArray *>(getClassWord())->elem_type;
+    }
+    const void *getData() const
     {
         return data_;
     }
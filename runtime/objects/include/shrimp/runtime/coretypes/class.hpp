@@ -43,6 +43,11 @@ public:
         auto size = field.size;
         memcpy(data_ + offset, &value, size);
     }
+    // Reference fields occupy whole slot
+    uint64_t *getRefFieldAddr(const RuntimeField &field)
+    {
+        return data_ + field.offset;
+    }
     void setData(uint64_t *data, uint32_t size)
     {
         if (data == nullptr) {
@@ -1,38 +1,173 @@
 #ifndef RUNTIME_CORETYPES_STRING_HPP
 #define RUNTIME_CORETYPES_STRING_HPP
 
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <vector>
 #include <shrimp/runtime/memory/object_header.hpp>
 #include <shrimp/runtime/shrimp_vm.hpp>
 
 namespace shrimp::runtime {
 
+// String of one of representations told by its class: flat string holds its contents, slice refers
+// to part of flat string and rope to two strings it is concatenation of. Rope is flattened when its
+// contents are needed and keeps flat copy as its only part. Header is followed only by size, hash code
+// is kept in mark word
 class String : public ObjectHeader {
 public:
+    // Shorter substrings and concatenations are copied, since slice or rope is as big as them
+    static constexpr uint32_t MIN_SLICE_SIZE = 32;
+    static constexpr uint32_t MIN_ROPE_SIZE = 32;
+
     static String *SubStr(String *strObj, uint32_t pos, uint32_t size, ShrimpVM *vm)
     {
-        std::string str = std::string(strObj->getData()).substr(pos, size);
-        return AllocateString(size, str.data(), vm);
+        pos = std::min(pos, strObj->getSize());
+        size = std::min(size, strObj->getSize() - pos);
+        strObj = Flatten(strObj, vm);
+        if (size < MIN_SLICE_SIZE) {
+            return AllocateString(size, strObj->getData() + pos, vm);
+        }
+        // Slices always refer to flat strings
+        if (strObj->getKind() == StringKind::SLICE) {
+            pos += strObj->getOffset();
+            strObj = strObj->getPart(0);
+        }
+        auto ptr = Allocate(StringKind::SLICE, size, REFS_OFFSET + sizeof(uint64_t), vm);
+        if (ptr != nullptr) {
+            ptr->setPart(0, strObj, vm);
+            ptr->setOffset(pos);
+        }
+        return ptr;
     }
     static String *ConcatStrings(String *strObj0, String *strObj1, ShrimpVM *vm)
     {
-        uint32_t len = strObj0->getSize() + strObj1->getSize();
-        std::string str = std::string(strObj0->getData()) + std::string(strObj1->getData());
-        return AllocateString(len, str.data(), vm);
+        uint32_t size0 = strObj0->getSize();
+        uint32_t size1 = strObj1->getSize();
+        // Strings are immutable, so concatenation with empty string is the other one
+        if (size0 == 0 || size1 == 0) {
+            return size0 == 0 ? strObj1 : strObj0;
+        }
+        if (size0 + size1 >= MIN_ROPE_SIZE) {
+            auto ptr = Allocate(StringKind::ROPE, size0 + size1, REFS_OFFSET + 2 * sizeof(uint64_t), vm);
+            if (ptr != nullptr) {
+                ptr->setPart(0, strObj0, vm);
+                ptr->setPart(1, strObj1, vm);
+            }
+            return ptr;
+        }
+        // Parts are not ropes, ropes are longer
+        auto ptr = AllocateString(size0 + size1, nullptr, vm);
+        if (ptr != nullptr) {
+            std::memcpy(ptr->data_, strObj0->getData(), size0);
+            std::memcpy(ptr->data_ + size0, strObj1->getData(), size1);
+        }
+        return ptr;
     }
+    // Strings of single character are shared, they are allocated on first request
     static String *AllocateString(uint32_t size, const char *data, ShrimpVM *vm)
     {
-        auto ptr = reinterpret_cast<String *>(
-            vm->getAllocator().allocate(sizeof(ObjectHeader) + sizeof(size) + sizeof(hashCode_) + size));
+        if (size == 1 && data != nullptr) {
+            return GetCharString(*data, vm);
+        }
+        auto ptr = Allocate(StringKind::FLAT, size, size, vm);
         if (ptr != nullptr) {
-            ptr->setSize(size);
-            ptr->setHashCode(0xd09c);
             ptr->setData(data);
-            ptr->setClassWord(reinterpret_cast<ClassWord>(&vm->getStringClass()));
         }
         return ptr;
     }
+    // Get string with contiguous contents equal to strObj: rope is copied to new flat string
+    // on first call, which is kept in rope, other strings are returned as is
+    static String *Flatten(String *strObj, ShrimpVM *vm)
+    {
+        if (strObj->getKind() != StringKind::ROPE) {
+            return strObj;
+        }
+        if (strObj->isFlattened()) {
+            return strObj->getPart(0);
+        }
+        auto flatObj = AllocateString(strObj->getSize(), nullptr, vm);
+        if (flatObj == nullptr) {
+            return nullptr;
+        }
+        // Parts are copied from left to right, explicit stack keeps deep ropes off native stack
+        std::vector<String *> parts {strObj};
+        char *dst = flatObj->data_;
+        while (!parts.empty()) {
+            auto *part = parts.back();
+            parts.pop_back();
+            if (part->getKind() == StringKind::ROPE && !part->isFlattened()) {
+                parts.push_back(part->getPart(1));
+                parts.push_back(part->getPart(0));
+                continue;
+            }
+            std::memcpy(dst, part->getData(), part->getSize());
+            dst += part->getSize();
+        }
+        auto &heap = vm->getAllocator();
+        heap.writeBarrier(strObj, *strObj->getRefAddr(0));
+        heap.writeBarrier(strObj, *strObj->getRefAddr(1));
+        strObj->setPart(0, flatObj);
+        strObj->setPart(1, nullptr);
+        return flatObj;
+    }
+    // Get interned string equal to strObj, flat copy of rope or strObj itself is interned if there is none
+    static String *Intern(String *strObj, ShrimpVM *vm)
+    {
+        strObj = Flatten(strObj, vm);
+        auto &table = vm->getInternTable();
+        uint32_t hash = strObj->getHashCode();
+        uint64_t ref = table.find(hash, [strObj](uint64_t other) {
+            auto *otherObj = reinterpret_cast<String *>(other);
+            return otherObj->getSize() == strObj->getSize() &&
+                   std::memcmp(otherObj->getData(), strObj->getData(), strObj->getSize()) == 0;
+        });
+        if (ref != 0) {
+            vm->getAllocator().keepAlive(ref);
+            return reinterpret_cast<String *>(ref);
+        }
+        ref = reinterpret_cast<uint64_t>(strObj);
+        table.insert(hash, ref, vm->getAllocator().isYoung(ref));
+        return strObj;
+    }
+    // Interned strings are equal only if they are the same object, others are compared
+    // by size and hash code before contents
+    static bool IsEqual(String *strObj0, String *strObj1, ShrimpVM *vm)
+    {
+        if (strObj0 == strObj1) {
+            return true;
+        }
+        if (strObj0->getSize() != strObj1->getSize()) {
+            return false;
+        }
+        strObj0 = Flatten(strObj0, vm);
+        strObj1 = Flatten(strObj1, vm);
+        if (strObj0->getHashCode() != strObj1->getHashCode()) {
+            return false;
+        }
+        return std::memcmp(strObj0->getData(), strObj1->getData(), strObj0->getSize()) == 0;
+    }
+    // wyhash style hash of contents: 16 byte blocks are mixed by 64x64->128 bit multiplication
+    static uint32_t ComputeHash(const char *data, uint32_t size)
+    {
+        constexpr uint64_t SECRET0 = 0xa0761d6478bd642f;
+        constexpr uint64_t SECRET1 = 0xe7037ed1a0b428db;
+        uint64_t seed = SECRET0 ^ size;
+        uint32_t pos = 0;
+        for (; pos + 16 <= size; pos += 16) {
+            seed = Mix(Read64(data + pos) ^ SECRET1, Read64(data + pos + 8) ^ seed);
+        }
+        uint64_t tail0 = 0;
+        uint64_t tail1 = 0;
+        uint32_t rest = size - pos;
+        std::memcpy(&tail0, data + pos, std::min<uint32_t>(rest, 8));
+        if (rest > 8) {
+            std::memcpy(&tail1, data + pos + 8, rest - 8);
+        }
+        uint64_t hash = Mix(SECRET1 ^ size, Mix(tail0 ^ SECRET1, tail1 ^ seed));
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
     void setData(const char *data)
     {
         if (data == nullptr) {
@@ -44,26 +179,122 @@ public:
     {
         size_ = size;
     }
-    void setHashCode(uint32_t hashCode)
-    {
-        hashCode_ = hashCode;
-    }
     uint32_t getSize()
     {
         return size_;
     }
+    StringKind getKind()
+    {
+        return reinterpret_cast<const RuntimeString *>(getClassWord())->kind;
+    }
+    // Contents are contiguous, only ropes need to be flattened
+    bool isFlattened()
+    {
+        return getKind() != StringKind::ROPE || getPart(1) == nullptr;
+    }
+    // Hash code is computed on first request and kept in mark word, HASHED state tells it is valid.
+    // Rope must be flattened first
     uint32_t getHashCode()
     {
-        return hashCode_;
+        if (!isHashed()) {
+            setHash(ComputeHash(getData(), size_));
+        }
+        return getHash();
+    }
+    // Rope must be flattened first
+    const char *getData()
+    {
+        switch (getKind()) {
+            case StringKind::SLICE:
+                return getPart(0)->data_ + getOffset();
+            case StringKind::ROPE:
+                assert(isFlattened());
+                return getPart(0)->data_;
+            default:
+                return data_;
+        }
+    }
+    // Parent of slice and parts of rope are references, which GC visits
+    uint32_t getNumOfRefs()
+    {
+        switch (getKind()) {
+            case StringKind::SLICE:
+                return 1;
+            case StringKind::ROPE:
+                return 2;
+            default:
+                return 0;
+        }
     }
-    const char *getData() const
+    uint64_t *getRefAddr(uint32_t idx)
     {
-        return data_;
+        return reinterpret_cast<uint64_t *>(data_ + REFS_OFFSET) + idx;
     }
 
 private:
+    // References are 8 byte aligned past size, slice keeps its offset before them
+    static constexpr uint32_t REFS_OFFSET = sizeof(uint32_t);
+
+    static String *Allocate(StringKind kind, uint32_t size, uint32_t data_size, ShrimpVM *vm)
+    {
+        auto ptr =
+            reinterpret_cast<String *>(vm->getAllocator().allocate(sizeof(ObjectHeader) + sizeof(size_) + data_size));
+        if (ptr != nullptr) {
+            ptr->setSize(size);
+            ptr->setClassWord(reinterpret_cast<ClassWord>(&vm->getStringClass(kind)));
+        }
+        return ptr;
+    }
+    static String *GetCharString(char c, ShrimpVM *vm)
+    {
+        auto &slot = vm->getCharString(static_cast<unsigned char>(c));
+        if (slot == 0) {
+            auto ptr = Allocate(StringKind::FLAT, 1, 1, vm);
+            if (ptr == nullptr) {
+                return nullptr;
+            }
+            ptr->setData(&c);
+            slot = reinterpret_cast<uint64_t>(ptr);
+        }
+        return reinterpret_cast<String *>(slot);
+    }
+    String *getPart(uint32_t idx)
+    {
+        return reinterpret_cast<String *>(*getRefAddr(idx));
+    }
+    // Part of new string: it may be allocated in old space after earlier allocations filled nursery,
+    // so its card is marked for minor GC to find young part
+    void setPart(uint32_t idx, String *part, ShrimpVM *vm)
+    {
+        vm->getAllocator().writeBarrier(this, 0);
+        setPart(idx, part);
+    }
+    void setPart(uint32_t idx, String *part)
+    {
+        *getRefAddr(idx) = reinterpret_cast<uint64_t>(part);
+    }
+    // Offset of slice in its parent precedes reference to parent
+    uint32_t getOffset()
+    {
+        return *reinterpret_cast<uint32_t *>(data_);
+    }
+    void setOffset(uint32_t offset)
+    {
+        *reinterpret_cast<uint32_t *>(data_) = offset;
+    }
+    static uint64_t Read64(const char *data)
+    {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    static uint64_t Mix(uint64_t lhs, uint64_t rhs)
+    {
+        auto product = static_cast<unsigned __int128>(lhs) * rhs;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+    }
+
     uint32_t size_;
-    uint32_t hashCode_;
     __extension__ char data_[0];
 };
 
@@ -1,34 +1,51 @@
 #ifndef SHRIMP_RUNTIME_SHRIMP_VM_HPP
 #define SHRIMP_RUNTIME_SHRIMP_VM_HPP
 
+#include <array>
 #include <list>
+#include <unordered_map>
 #include <vector>
 #include <cstdint>
 #include <stack>
 #include <cassert>
 #include <algorithm>
+#include <memory>
 
 #include <shrimp/common/logger.hpp>
 
+#include <shrimp/runtime/decoded_instr.hpp>
 #include <shrimp/runtime/frame.hpp>
+#include <shrimp/runtime/stack.hpp>
+#include <shrimp/runtime/stack_map.hpp>
 #include <shrimp/runtime/runtime.hpp>
+#include <shrimp/runtime/interpreter/decoded_code.hpp>
+#include <shrimp/runtime/interpreter/intrinsics.hpp>
 
 #include <shrimp/shrimpfile.hpp>
 #include <shrimp/common/types.hpp>
 
+#include <shrimp/runtime/memory/gc_options.hpp>
+#include <shrimp/runtime/memory/generational_heap.hpp>
+#include <shrimp/runtime/memory/intern_table.hpp>
 #include <shrimp/runtime/memory/memory_resource.hpp>
 
 namespace shrimp::runtime {
 
+namespace mem {
+class GC;
+}  // namespace mem
+
 class ShrimpVM final {
 public:
     ShrimpVM(std::vector<Byte> code, std::vector<shrimpfile::File::FileString> strings,
              std::vector<shrimpfile::File::FileFunction> funcs, std::vector<shrimpfile::File::FileClass> classes,
-             LogLevel log_level)
-        : log_level_(log_level), code_(std::move(code))
+             std::vector<shrimpfile::File::FileStackMap> stack_maps, LogLevel log_level,
+             const mem::GCOptions &gc_options = {})
+        : log_level_(log_level), gc_options_(gc_options), code_(std::move(code))
     {
         for (auto &&str : strings) {
             strings_.emplace(str.id, str.str);
+            interned_strings_.resize(std::max<size_t>(interned_strings_.size(), str.id + 1));
         }
         for (auto &&func : funcs) {
             funcs_.emplace(func.id, RuntimeFunc {func.func_start, func.num_of_args, func.num_of_vregs, func.name});
@@ -40,6 +57,11 @@ public:
             }
             classes_.push_back(RuntimeClass {{BaseClassType::DEFAULT}, klass.size, klass.name, std::move(fields)});
         }
+        for (auto &&stack_map : stack_maps) {
+            stack_maps_.emplace(decoded_code_.getInstr(stack_map.offset),
+                                StackMap {stack_map.refs, stack_map.ambiguous,
+                                          static_cast<StackMap::AccKind>(stack_map.acc_kind)});
+        }
         auto is_main = [](const std::pair<const unsigned int, shrimp::RuntimeFunc> &func_pair) {
             return func_pair.second.name == "main";
         };
@@ -49,14 +71,13 @@ public:
             std::abort();
         }
         FuncId entry_id = it->first;
-        stack_.push_back(Frame {std::make_shared<RuntimeFunc>(funcs_[entry_id])});
-        stringClass_ = BaseClass {STRING};
-        pc_ += stack_.back().getOffsetToFunc();
+        stack_.push(funcs_[entry_id]);
+        pc_ = decoded_code_.getInstr(stack_.top().getOffsetToFunc());
     }
 
     int runImpl();
 
-    const Byte *&pc() noexcept
+    const DecodedInstr *&pc() noexcept
     {
         return pc_;
     }
@@ -83,7 +104,7 @@ public:
 
     inline auto &currFrame() noexcept
     {
-        return stack_.back();
+        return stack_.top();
     }
 
     const std::string &resolveString(StrId str_id) noexcept
@@ -91,6 +112,11 @@ public:
         return strings_[str_id];
     }
 
+    auto &getInternTable() noexcept
+    {
+        return intern_table_;
+    }
+
     const RuntimeFunc &resolveFunc(FuncId func_id) noexcept
     {
         return funcs_[func_id];
@@ -105,16 +131,59 @@ public:
     {
         StrId str_id = strings_.size();
         strings_.emplace(str_id, std::move(str));
+        interned_strings_.resize(std::max<size_t>(interned_strings_.size(), str_id + 1));
         return str_id;
     }
-    const Byte *getPcFromStart(ByteOffset offset) noexcept
+
+    // Reference to string object of constant, zero until it is loaded the first time
+    uint64_t &getInternedString(StrId str_id) noexcept
+    {
+        return interned_strings_[str_id];
+    }
+
+    // Interned string objects are GC roots
+    auto &getInternedStrings() noexcept
+    {
+        return interned_strings_;
+    }
+
+    // Reference to string object of single character, zero until it is needed the first time
+    uint64_t &getCharString(unsigned char c) noexcept
+    {
+        return char_strings_[c];
+    }
+
+    // Single character strings are GC roots
+    auto &getCharStrings() noexcept
+    {
+        return char_strings_;
+    }
+
+    const DecodedInstr *getPcFromStart(ByteOffset offset) noexcept
+    {
+        return decoded_code_.getInstr(offset);
+    }
+
+    auto &getDecodedCode() noexcept
+    {
+        return decoded_code_;
+    }
+
+    // Get stack map of safepoint instruction or nullptr if there is none
+    const StackMap *findStackMap(const DecodedInstr *pc) const noexcept
     {
-        return code_.data() + offset;
+        auto it = stack_maps_.find(pc);
+        return it == stack_maps_.end() ? nullptr : &it->second;
     }
 
     auto &getAllocator() noexcept
     {
-        return allocator_;
+        return heap_;
+    }
+
+    auto &getOutput() noexcept
+    {
+        return output_;
     }
 
     auto &getClasses() noexcept
@@ -122,38 +191,78 @@ public:
         return classes_;
     }
 
-    auto &getArrays() noexcept
+    // Class of arrays of i32 or f elements
+    const RuntimeArray &getArrayClass(ArrayElemType elem_type) const noexcept
+    {
+        assert(elem_type != ArrayElemType::REF);
+        return elem_type == ArrayElemType::I32 ? i32_array_class_ : f_array_class_;
+    }
+
+    // Class of arrays of references to klass, created by the first allocation of such array
+    const RuntimeArray &getRefArrayClass(const RuntimeClass &klass)
     {
-        return arrays_;
+        auto [it, is_new] = ref_array_classes_.try_emplace(&klass);
+        if (is_new) {
+            it->second = RuntimeArray {{BaseClassType::ARRAY}, ArrayElemType::REF, &klass};
+        }
+        return it->second;
     }
 
-    auto &getStringClass() noexcept
+    // Class of strings of given representation
+    const RuntimeString &getStringClass(StringKind kind) const noexcept
     {
-        return stringClass_;
+        return string_classes_[static_cast<size_t>(kind)];
     }
 
     void triggerGCIfNeed();
 
 private:
+    // Select interpreter instantiation for the current log level
+    int runInterpreter();
+
     Runtime *runtime_ = nullptr;
     LogLevel log_level_ = LogLevel::NONE;
+    mem::GCOptions gc_options_ {};
 
     std::vector<Byte> code_ {};
-    const Byte *pc_ = code_.data();
+    interpreter::DecodedCode decoded_code_ {code_};
+    const DecodedInstr *pc_ = nullptr;
 
-    Register acc_ {};
-    std::vector<Frame> stack_ {};
+    uint64_t acc_ = 0;
+    intrinsics::OutputBuffer output_;
+    std::unordered_map<const DecodedInstr *, StackMap> stack_maps_;
+    // Reserved, committed on touch
+    static constexpr size_t STACK_MAX_FRAMES = 0x10000;
+    static constexpr size_t STACK_MAX_REGS = 0x1000000;
+    Stack stack_ {STACK_MAX_FRAMES, STACK_MAX_REGS};
 
     StringAccessor strings_;
+    // String objects of constants indexed by id, so lda.str allocates each of them once
+    std::vector<uint64_t> interned_strings_;
+    // Strings interned by lda.str and str.intern, weak for GC
+    InternTable intern_table_;
+    // String objects of single characters indexed by character, shared by all strings of one character
+    std::array<uint64_t, 256> char_strings_ {};
     FuncAccessor funcs_;
     ClassAccessor classes_;
-    ArrayAccessor arrays_;
 
-    BaseClass stringClass_;
+    std::array<RuntimeString, 3> string_classes_ {RuntimeString {{BaseClassType::STRING}, StringKind::FLAT},
+                                                  RuntimeString {{BaseClassType::STRING}, StringKind::SLICE},
+                                                  RuntimeString {{BaseClassType::STRING}, StringKind::ROPE}};
+    RuntimeArray i32_array_class_ {{BaseClassType::ARRAY}, ArrayElemType::I32};
+    RuntimeArray f_array_class_ {{BaseClassType::ARRAY}, ArrayElemType::F};
+    // Node based, so class words of arrays stay valid
+    std::unordered_map<const RuntimeClass *, RuntimeArray> ref_array_classes_;
 
-    static constexpr size_t MEM_LIMIT = 0x2000000;  // 32Mb
-    LimitedArena arena_ {MEM_LIMIT};
-    LimitedMemRes allocator_ {arena_};
+    static constexpr size_t NURSERY_SIZE = 0x200000;  // 2Mb
+    LimitedArena arena_ {gc_options_.heap_max};
+    GenerationalHeap heap_ {arena_, NURSERY_SIZE, gc_options_.heap_min};
+    // GC is defined after VM, so it is deleted in translation unit
+    struct GCDeleter {
+        void operator()(mem::GC *gc) const noexcept;
+    };
+    // Keeps incremental marking state between pauses
+    std::unique_ptr<mem::GC, GCDeleter> gc_;
 };
 
 }  // namespace shrimp::runtime
@@ -5,24 +5,46 @@
 
 namespace shrimp::runtime {
 
+void ShrimpVM::GCDeleter::operator()(mem::GC *gc) const noexcept
+{
+    delete gc;
+}
+
 int ShrimpVM::runImpl()
 {
     assert(!stack_.empty());
-    auto status = interpreter::runImpl(this);
+    auto status = runInterpreter();
+    output_.flush();
     if (status != 0) {
         return -1;
     }
-    return acc().getValue();
+    return acc();
+}
+
+int ShrimpVM::runInterpreter()
+{
+    switch (log_level_) {
+        case LogLevel::ERROR:
+            return interpreter::runImpl<LogLevel::ERROR>(this);
+        case LogLevel::INFO:
+            return interpreter::runImpl<LogLevel::INFO>(this);
+        case LogLevel::DEBUG:
+            return interpreter::runImpl<LogLevel::DEBUG>(this);
+        default:
+            return interpreter::runImpl<LogLevel::NONE>(this);
+    }
 }
 
 void ShrimpVM::triggerGCIfNeed()
 {
-    if (10 * getAllocator().getAllocated() < 9 * MEM_LIMIT) {
+    if (!heap_.isNurseryFull() && !heap_.isOldSpaceFull() && !heap_.isStepDue()) [[likely]] {
         return;
     }
     LOG_DEBUG("GC WAS TRIGGERED", getLogLevel());
-    mem::GC gc {this};
-    gc.run();
+    if (gc_ == nullptr) {
+        gc_.reset(new mem::GC(this, gc_options_));
+    }
+    gc_->run();
 }
 
 }  // namespace shrimp::runtime
@@ -0,0 +1,33 @@
+import sys
+import os
+import subprocess
+import tempfile
+import time
+
+THREADS = [1, 2, 4, 8]
+RUNS = 3
+
+def assemble(bin_dir, source, out) :
+	subprocess.run([os.path.join(bin_dir, "assembler"), "--in", source, "--out", out], check=True)
+
+# Best wall time of several runs, GC marking dominates in benchmark
+def measure(bin_dir, program, threads) :
+	best = None
+	for _ in range(RUNS) :
+		start = time.perf_counter()
+		subprocess.run([os.path.join(bin_dir, "shrimp"), "--in", program, "--gc-threads", str(threads)], check=True)
+		elapsed = time.perf_counter() - start
+		best = elapsed if best is None else min(best, elapsed)
+	return best
+
+if __name__ == '__main__' :
+	bin_dir = sys.argv[1]
+	source = sys.argv[2]
+	with tempfile.TemporaryDirectory() as tmp_dir :
+		program = os.path.join(tmp_dir, "bench.imp")
+		assemble(bin_dir, source, program)
+		base = None
+		for threads in THREADS :
+			elapsed = measure(bin_dir, program, threads)
+			base = elapsed if base is None else base
+			print(f"gc threads {threads}: {elapsed:.3f} s, speedup {base / elapsed:.2f}")
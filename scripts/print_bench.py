@@ -0,0 +1,31 @@
+import sys
+import os
+import subprocess
+import tempfile
+import time
+
+RUNS = 3
+
+def assemble(bin_dir, source, out) :
+	subprocess.run([os.path.join(bin_dir, "assembler"), "--in", source, "--out", out], check=True)
+
+# Best wall time of several runs, output is read from pipe as terminal or another process would do
+def measure(bin_dir, program) :
+	best = None
+	lines = 0
+	for _ in range(RUNS) :
+		start = time.perf_counter()
+		res = subprocess.run([os.path.join(bin_dir, "shrimp"), "--in", program], stdout=subprocess.PIPE, check=True)
+		elapsed = time.perf_counter() - start
+		lines = res.stdout.count(b"\n")
+		best = elapsed if best is None else min(best, elapsed)
+	return best, lines
+
+if __name__ == '__main__' :
+	bin_dir = sys.argv[1]
+	source = sys.argv[2]
+	with tempfile.TemporaryDirectory() as tmp_dir :
+		program = os.path.join(tmp_dir, "bench.imp")
+		assemble(bin_dir, source, program)
+		elapsed, lines = measure(bin_dir, program)
+		print(f"printed {lines} lines: {elapsed:.3f} s")
@@ -6,6 +6,7 @@
 #include <fstream>
 #include <algorithm>
 #include <iterator>
+#include <chrono>
 
 #include <shrimp/common/logger.hpp>
 
@@ -30,8 +31,34 @@ int Main(int argc, char *argv[])
     auto *input_arg = app.add_option("--in", input_file, "Input file");
     input_arg->required();
 
+    uint64_t gc_max_pause_us = 0;
+    auto *gc_max_pause_cli = app.add_option("--gc-max-pause", gc_max_pause_us,
+                                            "Max GC pause in microseconds, enables incremental marking");
+    gc_max_pause_cli->default_str("0");
+
+    size_t gc_threads = 1;
+    auto *gc_threads_cli = app.add_option("--gc-threads", gc_threads, "Number of GC threads marking in parallel");
+    gc_threads_cli->default_str("1");
+    gc_threads_cli->check(CLI::PositiveNumber);
+
+    // Nursery takes 2Mb, forwarding addresses of GC cover 16Gb
+    size_t heap_min_mb = 64;
+    auto *heap_min_cli = app.add_option("--heap-min", heap_min_mb, "Initial heap size in Mb");
+    heap_min_cli->default_str("64");
+    heap_min_cli->check(CLI::Range(4, 16384));
+
+    size_t heap_max_mb = 4096;
+    auto *heap_max_cli = app.add_option("--heap-max", heap_max_mb, "Max heap size in Mb");
+    heap_max_cli->default_str("4096");
+    heap_max_cli->check(CLI::Range(4, 16384));
+
     CLI11_PARSE(app, argc, argv);
 
+    if (heap_min_mb > heap_max_mb) {
+        std::cerr << "Initial heap size is greater than max one" << std::endl;
+        return 1;
+    }
+
     LogLevel log_level = getLogLevelByString(log_level_str);
 
     shrimpfile::File ifile {input_file};
@@ -42,8 +69,12 @@ int Main(int argc, char *argv[])
     auto strings_info = ifile.getStringsInfo();
     auto funcs_info = ifile.getFuncsInfo();
     auto classes_info = ifile.getClassesInfo();
+    auto stack_maps_info = ifile.getStackMapsInfo();
+
+    runtime::mem::GCOptions gc_options {std::chrono::microseconds(gc_max_pause_us), gc_threads, heap_min_mb << 20,
+                                        heap_max_mb << 20};
 
-    runtime::ShrimpVM svm {native_code, strings_info, funcs_info, classes_info, log_level};
+    runtime::ShrimpVM svm {native_code, strings_info, funcs_info, classes_info, stack_maps_info, log_level, gc_options};
 
     return svm.runImpl();
     return 0;
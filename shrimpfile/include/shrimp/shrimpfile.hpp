@@ -17,7 +17,9 @@ constexpr size_t FILENAME_SIZE = 32;
 
 class File final {
 public:
-    enum Headers { CODE = 0, LITERALS, FUNCTIONS, CLASSES, HEADERS_NUM };
+    enum Headers { CODE = 0, LITERALS, FUNCTIONS, CLASSES, STACK_MAPS, HEADERS_NUM };
+    // Kind of accumulator value at safepoint
+    enum AccKind : uint8_t { ACC_VALUE = 0, ACC_REF, ACC_AMBIGUOUS };
 
     File() = default;
     explicit File(const std::string &src_file_name, const std::string &bin_file_name);
@@ -50,6 +52,7 @@ public:
     EntityHeader_t FileStringHeader;
     EntityHeader_t FileFuncHeader;
     EntityHeader_t FileClassHeader;
+    EntityHeader_t FileStackMapHeader;
 
     struct FileField {
         FieldId id = 0;
@@ -78,6 +81,17 @@ public:
         std::vector<FileField> fields;
     };
 
+    // Registers holding references at safepoint instruction. Ambiguous
+    // registers hold reference or value depending on path to safepoint
+    struct FileStackMap {
+        ByteOffset offset = 0;
+        uint8_t acc_kind = ACC_VALUE;
+        uint16_t num_of_refs = 0;
+        std::vector<R8Id> refs;
+        uint16_t num_of_ambiguous = 0;
+        std::vector<R8Id> ambiguous;
+    };
+
     struct FileString {
         StrId id = 0;
         uint64_t str_size = 0;
@@ -88,6 +102,7 @@ public:
     void writeString(const std::string &str, StrId str_id);
     void writeFunction(const FileFunction &func);
     void writeClass(const FileClass &klass);
+    void writeStackMap(const FileStackMap &stack_map);
     std::string dump();
 
     auto getCode() noexcept
@@ -110,16 +125,23 @@ public:
         return Classes;
     }
 
+    auto &getStackMapsInfo() noexcept
+    {
+        return StackMaps;
+    }
+
 private:
     void fillCodeHeader();
     void fillStringsHeader();
     void fillFunctionsHeader();
     void fillClassesHeader();
+    void fillStackMapsHeader();
 
     std::string bin_file_path_;
     std::vector<FileString> Strings;
     std::vector<FileFunction> Functions;
     std::vector<FileClass> Classes;
+    std::vector<FileStackMap> StackMaps;
     std::vector<Byte> Code;
 
     void serializeCode(std::FILE *out);
@@ -128,6 +150,7 @@ private:
     void serializeFunctions(std::FILE *out);
     void serializeHeaders(std::FILE *out);
     void serializeClasses(std::FILE *out);
+    void serializeStackMaps(std::FILE *out);
 
     void dumpFileHeader(std::stringstream &ss);
     void dumpCodeHeader(std::stringstream &ss);
@@ -138,6 +161,8 @@ private:
     void dumpFunction(std::stringstream &ss);
     void dumpClassHeader(std::stringstream &ss);
     void dumpClasses(std::stringstream &ss);
+    void dumpStackMapHeader(std::stringstream &ss);
+    void dumpStackMaps(std::stringstream &ss);
 };
 
 constexpr size_t HEADERS_NUM = File::Headers::HEADERS_NUM;
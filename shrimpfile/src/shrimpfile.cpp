@@ -61,6 +61,10 @@ File::File(const std::string &file_name)
     ownRead(&FileFuncHeader.num, sizeof(FileFuncHeader.num), 1, file);
     ownRead(&FileFuncHeader.header_size, sizeof(FileFuncHeader.header_size), 1, file);
 
+    // Read FileStackMapHeader
+    ownRead(&FileStackMapHeader.num, sizeof(FileStackMapHeader.num), 1, file);
+    ownRead(&FileStackMapHeader.header_size, sizeof(FileStackMapHeader.header_size), 1, file);
+
     // Read Class Section
     std::vector<FileClass> classes(FileClassHeader.num);
     fseek(file, FileHeader.headers[CLASSES].offset_from_start, SEEK_SET);
@@ -120,6 +124,21 @@ File::File(const std::string &file_name)
     }
     Functions = functions;
 
+    // Read Stack Map Section
+    std::vector<FileStackMap> stack_maps(FileStackMapHeader.num);
+    fseek(file, FileHeader.headers[STACK_MAPS].offset_from_start, SEEK_SET);
+    for (auto &stack_map : stack_maps) {
+        ownRead(&stack_map.offset, sizeof(stack_map.offset), 1, file);
+        ownRead(&stack_map.acc_kind, sizeof(stack_map.acc_kind), 1, file);
+        ownRead(&stack_map.num_of_refs, sizeof(stack_map.num_of_refs), 1, file);
+        stack_map.refs.resize(stack_map.num_of_refs);
+        ownRead(stack_map.refs.data(), sizeof(R8Id), stack_map.refs.size(), file);
+        ownRead(&stack_map.num_of_ambiguous, sizeof(stack_map.num_of_ambiguous), 1, file);
+        stack_map.ambiguous.resize(stack_map.num_of_ambiguous);
+        ownRead(stack_map.ambiguous.data(), sizeof(R8Id), stack_map.ambiguous.size(), file);
+    }
+    StackMaps = stack_maps;
+
     fclose(file);
 }
 
@@ -129,6 +148,7 @@ void File::fillHeaders()
     fillCodeHeader();
     fillStringsHeader();
     fillFunctionsHeader();
+    fillStackMapsHeader();
 }
 
 void File::fillCodeHeader()
@@ -136,7 +156,7 @@ void File::fillCodeHeader()
     auto &codeHeader = FileHeader.headers[CODE];
     codeHeader.offset_from_start = FileHeader.file_header_size + FileStringHeader.header_size +
                                    FileFuncHeader.header_size + FileClassHeader.header_size +
-                                   FileHeader.headers[CLASSES].size;
+                                   FileStackMapHeader.header_size + FileHeader.headers[CLASSES].size;
     codeHeader.size = Code.size();
 }
 
@@ -145,7 +165,8 @@ void File::fillStringsHeader()
     auto &stringHeader = FileHeader.headers[LITERALS];
     stringHeader.offset_from_start = FileHeader.file_header_size + FileStringHeader.header_size +
                                      FileHeader.headers[CODE].size + FileFuncHeader.header_size +
-                                     FileHeader.headers[CLASSES].size + FileClassHeader.header_size;
+                                     FileHeader.headers[CLASSES].size + FileClassHeader.header_size +
+                                     FileStackMapHeader.header_size;
     FileStringHeader.num = Strings.size();
     stringHeader.size = 0;
     for (auto &str : Strings) {
@@ -159,7 +180,7 @@ void File::fillFunctionsHeader()
     funcHeader.offset_from_start = FileHeader.file_header_size + FileFuncHeader.header_size +
                                    FileHeader.headers[CODE].size + FileHeader.headers[LITERALS].size +
                                    FileHeader.headers[CLASSES].size + FileStringHeader.header_size +
-                                   FileClassHeader.header_size;
+                                   FileClassHeader.header_size + FileStackMapHeader.header_size;
     FileFuncHeader.num = Functions.size();
     funcHeader.size = 0;
     for (auto &func : Functions) {
@@ -172,7 +193,8 @@ void File::fillClassesHeader()
 {
     auto &classesHeader = FileHeader.headers[CLASSES];
     classesHeader.offset_from_start = FileHeader.file_header_size + FileStringHeader.header_size +
-                                      FileFuncHeader.header_size + FileClassHeader.header_size;
+                                      FileFuncHeader.header_size + FileClassHeader.header_size +
+                                      FileStackMapHeader.header_size;
     FileClassHeader.num = Classes.size();
     classesHeader.size = 0;
     for (auto &klass : Classes) {
@@ -185,6 +207,20 @@ void File::fillClassesHeader()
     }
 }
 
+void File::fillStackMapsHeader()
+{
+    auto &stackMapHeader = FileHeader.headers[STACK_MAPS];
+    stackMapHeader.offset_from_start =
+        FileHeader.headers[FUNCTIONS].offset_from_start + FileHeader.headers[FUNCTIONS].size;
+    FileStackMapHeader.num = StackMaps.size();
+    stackMapHeader.size = 0;
+    for (auto &stack_map : StackMaps) {
+        stackMapHeader.size += sizeof(stack_map.offset) + sizeof(stack_map.acc_kind) + sizeof(stack_map.num_of_refs) +
+                               stack_map.refs.size() * sizeof(R8Id) + sizeof(stack_map.num_of_ambiguous) +
+                               stack_map.ambiguous.size() * sizeof(R8Id);
+    }
+}
+
 void File::writeBytes(const char *bin_code, size_t size)
 {
     Code.insert(Code.end(), bin_code, bin_code + size);
@@ -205,6 +241,11 @@ void File::writeClass(const FileClass &klass)
     Classes.push_back(klass);
 }
 
+void File::writeStackMap(const FileStackMap &stack_map)
+{
+    StackMaps.push_back(stack_map);
+}
+
 void File::serialize()
 {
     std::FILE *out = std::fopen(bin_file_path_.data(), "wb");
@@ -214,6 +255,7 @@ void File::serialize()
     serializeCode(out);
     serializeStrings(out);
     serializeFunctions(out);
+    serializeStackMaps(out);
     fclose(out);
 }
 
@@ -234,6 +276,8 @@ void File::serializeHeaders(std::FILE *out)
     ownWrite(&FileStringHeader.header_size, sizeof(FileStringHeader.header_size), 1, out);
     ownWrite(&FileFuncHeader.num, sizeof(FileFuncHeader.num), 1, out);
     ownWrite(&FileFuncHeader.header_size, sizeof(FileFuncHeader.header_size), 1, out);
+    ownWrite(&FileStackMapHeader.num, sizeof(FileStackMapHeader.num), 1, out);
+    ownWrite(&FileStackMapHeader.header_size, sizeof(FileStackMapHeader.header_size), 1, out);
 }
 
 void File::serializeCode(std::FILE *out)
@@ -281,6 +325,18 @@ void File::serializeClasses(std::FILE *out)
     }
 }
 
+void File::serializeStackMaps(std::FILE *out)
+{
+    for (auto &stack_map : StackMaps) {
+        ownWrite(&stack_map.offset, sizeof(stack_map.offset), 1, out);
+        ownWrite(&stack_map.acc_kind, sizeof(stack_map.acc_kind), 1, out);
+        ownWrite(&stack_map.num_of_refs, sizeof(stack_map.num_of_refs), 1, out);
+        ownWrite(stack_map.refs.data(), sizeof(R8Id), stack_map.refs.size(), out);
+        ownWrite(&stack_map.num_of_ambiguous, sizeof(stack_map.num_of_ambiguous), 1, out);
+        ownWrite(stack_map.ambiguous.data(), sizeof(R8Id), stack_map.ambiguous.size(), out);
+    }
+}
+
 std::string File::dump()
 {
     std::stringstream ss;
@@ -293,6 +349,8 @@ std::string File::dump()
     dumpString(ss);
     dumpFunctionHeader(ss);
     dumpFunction(ss);
+    dumpStackMapHeader(ss);
+    dumpStackMaps(ss);
     return ss.str();
 }
 
@@ -387,4 +445,31 @@ void File::dumpClasses(std::stringstream &ss)
     }
 }
 
-}  // namespace shrimp::shrimpfile
\ No newline at end of file
+void File::dumpStackMapHeader(std::stringstream &ss)
+{
+    auto &stackMapPreHeader = FileHeader.headers[STACK_MAPS];
+    ss << "Stack Map Pre Header Size: " << stackMapPreHeader.size << std::endl;
+    ss << "Stack Map Pre Header Offset To Segment From Start: " << stackMapPreHeader.offset_from_start << std::endl;
+    ss << "Num of stack maps: " << FileStackMapHeader.num << std::endl;
+    ss << "Stack Map Header Size: " << FileStackMapHeader.header_size << std::endl;
+}
+
+void File::dumpStackMaps(std::stringstream &ss)
+{
+    for (auto &stack_map : StackMaps) {
+        ss << "Stack map offset : " << stack_map.offset << std::endl;
+        ss << "Stack map acc_kind : " << static_cast<uint32_t>(stack_map.acc_kind) << std::endl;
+        ss << "Stack map refs :";
+        for (auto reg : stack_map.refs) {
+            ss << " r" << static_cast<uint32_t>(reg);
+        }
+        ss << std::endl;
+        ss << "Stack map ambiguous :";
+        for (auto reg : stack_map.ambiguous) {
+            ss << " r" << static_cast<uint32_t>(reg);
+        }
+        ss << std::endl;
+    }
+}
+
+}  // namespace shrimp::shrimpfile
@@ -0,0 +1,13 @@
+# Run PROGRAM by SHRIMP, it must exit with error code and report EXPECTED_ERROR
+execute_process(
+	COMMAND ${SHRIMP} --in ${PROGRAM}
+	RESULT_VARIABLE result
+	ERROR_VARIABLE error
+)
+
+if(result EQUAL 0)
+	message(FATAL_ERROR "${PROGRAM} was expected to fail")
+endif()
+if(NOT error MATCHES "${EXPECTED_ERROR}")
+	message(FATAL_ERROR "${PROGRAM} failed with unexpected error: ${error}")
+endif()